@@ -13,7 +13,9 @@ AgentPackage::AgentPackage() :
   currentRank(),
   state(),
   origin(repast::Point< int >(0, 0)),
-  bufferValues()
+  bufferValues(),
+  secretions(),
+  planes()
 {}
 
 // For serialization
@@ -28,13 +30,17 @@ AgentPackage::AgentPackage(int _id,
   currentRank(_currentRank),
   state(),
   origin(repast::Point< int >(0, 0)),
-  bufferValues()
+  bufferValues(),
+  secretions(),
+  planes()
 {
   state = pAgent->getState();
 
   if ((Agent::Type) type == Agent::DiffuserValues)
     {
       static_cast< SharedValueLayer * >(pAgent)->getBufferValues(origin, bufferValues);
+      secretions = static_cast< SharedValueLayer * >(pAgent)->getSecretions();
+      planes = static_cast< SharedValueLayer * >(pAgent)->getExchangedPlanes();
     }
 }
 
@@ -82,7 +88,8 @@ Agent * AgentPackageExchange::createAgent(AgentPackage package)
     }
   else
     {
-      pAgent = new SharedValueLayer(package.id, package.rank, package.type, package.currentRank, package.state, package.origin, package.bufferValues);
+      pAgent = new SharedValueLayer(package.id, package.rank, package.type, package.currentRank, package.state, package.origin, package.bufferValues, package.planes);
+      static_cast< SharedValueLayer * >(pAgent)->setSecretions(package.secretions);
     }
 
   return pAgent;
@@ -101,6 +108,7 @@ void AgentPackageExchange::updateAgent(AgentPackage package)
     }
   else
     {
-      static_cast< SharedValueLayer * >(pAgent)->setBufferValues(package.origin, package.bufferValues);
+      static_cast< SharedValueLayer * >(pAgent)->setBufferValues(package.origin, package.bufferValues, package.planes);
+      static_cast< SharedValueLayer * >(pAgent)->setSecretions(package.secretions);
     }
 }
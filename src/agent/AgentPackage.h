@@ -2,6 +2,8 @@
 #define ENISI_AgentPackage
 
 #include "repast_hpc/SharedContext.h"
+#include "boost/serialization/map.hpp"
+#include "boost/serialization/vector.hpp"
 #include "SharedValueLayer.h"
 
 namespace ENISI
@@ -21,6 +23,8 @@ public:
   int    state;
   repast::Point< int > origin;
   SharedValueLayer::BufferValues bufferValues;
+  SharedValueLayer::Secretions secretions;
+  std::vector< size_t > planes;
 
   /* Constructors */
   AgentPackage();
@@ -45,6 +49,8 @@ public:
       {
         ar & origin;
         ar & bufferValues;
+        ar & secretions;
+        ar & planes;
       }
   }
 };
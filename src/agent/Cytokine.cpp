@@ -3,11 +3,12 @@
 
 using namespace ENISI;
 
-Cytokine::Cytokine(const std::string & name):
+Cytokine::Cytokine(const std::string & name, const double & gridSpacing):
   mName(name),
   mInitialValue(0.0),
   mDiffusion(0.0),
   mDegradation(0.0),
+  mSteadyStateInterval(0),
   mIndex((size_t) - 1)
 {
   const Properties * pProperties = Properties::instance(Properties::model);
@@ -15,6 +16,9 @@ Cytokine::Cytokine(const std::string & name):
   pProperties->getValue(mName + ".initialValue", mInitialValue);
   pProperties->getValue(mName + ".diffusion", mDiffusion);
   pProperties->getValue(mName + ".degradation", mDegradation);
+  pProperties->getValue(mName + ".steadyStateInterval", mSteadyStateInterval);
+
+  mDiffusion /= gridSpacing * gridSpacing;
 }
 
 Cytokine::~Cytokine()
@@ -40,6 +44,11 @@ const double & Cytokine::getDegradation() const
   return mDegradation;
 }
 
+const size_t & Cytokine::getSteadyStateInterval() const
+{
+  return mSteadyStateInterval;
+}
+
 const size_t & Cytokine::getIndex() const
 {
   return mIndex;
@@ -12,7 +12,11 @@ private:
   Cytokine();
 
 public:
-  Cytokine(const std::string & name);
+  /**
+   * The diffusion is specified for the agent grid, i.e., it is scaled to the cytokine grid whose
+   * cells have the edge length gridSpacing in agent cells.
+   */
+  Cytokine(const std::string & name, const double & gridSpacing = 1.0);
 
   ~Cytokine();
 
@@ -20,6 +24,11 @@ public:
   const double & getInitialValue() const;
   const double & getDiffusion() const;
   const double & getDegradation() const;
+
+  /**
+   * The number of ticks between steady state solves replacing the time stepped diffusion, 0 disables them.
+   */
+  const size_t & getSteadyStateInterval() const;
   const size_t & getIndex() const;
   void setIndex(const size_t & index);
 
@@ -28,6 +37,7 @@ private:
   double mInitialValue;
   double mDiffusion;
   double mDegradation;
+  size_t mSteadyStateInterval;
   size_t mIndex;
 
 };
@@ -189,8 +189,8 @@ void DendriticsGroup::act(const repast::Point<int> & pt)
 			}
 			if (p_edccyto > repast::Random::instance()-> createUniDoubleGenerator(0.0, 1.0).next() && (mpCompartment->getType() == Compartment::lamina_propria || mpCompartment->getType() == Compartment::gastric_lymph_node))
 			{
-				mpCompartment->cytokineValue("eIL6", pt) += 7;
-				mpCompartment->cytokineValue("eIL12",pt) += 7;
+				mpCompartment->secrete("eIL6", pt, 7);
+				mpCompartment->secrete("eIL12", pt, 7);
 			}
 			if ((p_dcdeath > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next()))
 			{
@@ -222,7 +222,7 @@ void DendriticsGroup::act(const repast::Point<int> & pt)
 			}
 			if (p_tdccyto > repast::Random::instance()-> createUniDoubleGenerator(0.0, 1.0).next() && (mpCompartment->getType() == Compartment::lamina_propria || mpCompartment->getType() == Compartment::gastric_lymph_node))
 			{
-				mpCompartment->cytokineValue("eTGFb", pt) += 7;
+				mpCompartment->secrete("eTGFb", pt, 7);
 			}
 			if ((p_dcdeath > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next()))
 			{
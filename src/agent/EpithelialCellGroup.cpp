@@ -268,8 +268,8 @@ void EpithelialCellGroup::act(const repast::Point<int> & pt)
 			if (p_epicyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 			{
 				int yOffset = mpCompartment->gridBorders()->distanceFromBorder(pt.coords(), Borders::Y, Borders::HIGH);
-				mpCompartment->cytokineValue("eIL6", pt, 0, yOffset) += 7;
-				mpCompartment->cytokineValue("eIL12", pt, 0, yOffset) += 7;
+				mpCompartment->secrete("eIL6", pt, 0, yOffset, 7);
+				mpCompartment->secrete("eIL12", pt, 0, yOffset, 7);
 			}
 			if (p_epiideath > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 			{
@@ -300,8 +300,8 @@ void EpithelialCellGroup::act(const repast::Point<int> & pt)
 			if (p_epicyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 			{
 				int yOffset = mpCompartment->gridBorders()->distanceFromBorder(pt.coords(), Borders::Y, Borders::HIGH);
-				mpCompartment->cytokineValue("eIL17", pt, 0, yOffset) += 7;
-				mpCompartment->cytokineValue("eIFNg", pt, 0, yOffset) += 7;
+				mpCompartment->secrete("eIL17", pt, 0, yOffset, 7);
+				mpCompartment->secrete("eIFNg", pt, 0, yOffset, 7);
 			}
 			if (p_epiddeath > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 			{
@@ -117,8 +117,8 @@ void MacrophageGroup::act(const repast::Point<int> & pt)
 		{
 			if (p_trmaccyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 			{
-				mpCompartment->cytokineValue("eIL10", pt) += 5;
-				mpCompartment->cytokineValue("eTGFb", pt) += 2;
+				mpCompartment->secrete("eIL10", pt, 5);
+				mpCompartment->secrete("eTGFb", pt, 2);
 			}
 			if ((epihealConcentration > ENISI::Threshold || trmacConcentration > ENISI::Threshold)
 					&& p_trmacrep > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next()
@@ -191,7 +191,7 @@ void MacrophageGroup::act(const repast::Point<int> & pt)
 		{
 			if (p_infmaccyto > repast::Random::instance()-> createUniDoubleGenerator(0.0, 1.0).next())
 			{
-				mpCompartment->cytokineValue("eIFNg", pt) += 5;
+				mpCompartment->secrete("eIFNg", pt, 5);
 			}
 			if ((epiinfConcentration > ENISI::Threshold || epidamConcentration > ENISI::Threshold || infmacConcentration > ENISI::Threshold) && p_monorec > repast::Random::instance()-> createUniDoubleGenerator(0.0, 1.0).next() && monosConcentration < p_trmacCap)
 			{
@@ -211,7 +211,7 @@ void MacrophageGroup::act(const repast::Point<int> & pt)
 		{
 			if (p_intmaccyto > repast::Random::instance()-> createUniDoubleGenerator(0.0, 1.0).next())
 			{
-				mpCompartment->cytokineValue("eTGFb", pt) += 5;
+				mpCompartment->secrete("eTGFb", pt, 5);
 			}
 			if ((epiinfConcentration > ENISI::Threshold || epidamConcentration > ENISI::Threshold) && p_monorec > repast::Random::instance()-> createUniDoubleGenerator(0.0, 1.0).next())
 			{
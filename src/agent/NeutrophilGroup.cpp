@@ -154,7 +154,7 @@ void NeutrophilGroup::act(const repast::Point<int> & pt)
 			else if (bacteriaDAConcentration > ENISI::Threshold
 					&& p_nkillbac > repast::Random::instance()->createUniDoubleGenerator(0.0,1.0).next())
 			{
-				mpCompartment->cytokineValue("eIL17", pt) += 1;
+				mpCompartment->secrete("eIL17", pt, 1);
 				if (BacteriaDAs.size() > 0)
 				{
 					mpCompartment->removeAgent(BacteriaDAs[BacteriaDAs.size() - 1]);
@@ -5,6 +5,8 @@
  *      Author: shoops
  */
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 
 #include "SharedValueLayer.h"
@@ -12,6 +14,7 @@
 #include "compartment/Compartment.h"
 #include "Cytokine.h"
 #include "DataWriter/LocalFile.h"
+#include "grid/Properties.h"
 
 // #define DEBUG_SHARED
 
@@ -22,38 +25,167 @@ SharedValueLayer::SharedValueLayer(const Type & type, const int & state, const s
   mValueSize(valueSize),
   mOrigin(0, 0),
   mShape(0, 0),
-  mpLocalValues(NULL),
-  mBufferValues()
+  mHalo(1),
+  mEdges(),
+  mpLocalValues(),
+  mCurrent(0),
+  mBufferValues(),
+  mSecretions(),
+  mExchangedPlanes()
 {
-  const repast::GridDimensions & GridDimensions = Compartment::instance((Compartment::Type) state)->localGridDimensions();
+  mpLocalValues[0] = mpLocalValues[1] = NULL;
+
+  const Compartment * pCompartment = Compartment::instance((Compartment::Type) state);
+  const repast::GridDimensions & GridDimensions = pCompartment->localDiffuserDimensions();
 
   mOrigin[0] = round(GridDimensions.origin(0));
   mOrigin[1] = round(GridDimensions.origin(1));
   mShape[0] = round(GridDimensions.extents(0));
   mShape[1] = round(GridDimensions.extents(1));
 
-  mpLocalValues = new LocalValues(repast::Point< int >(mShape[0] + 2, mShape[1] + 2),
-                                  std::vector< double >(mValueSize, std::numeric_limits< double >::quiet_NaN()));
+  // Cytokine slabs span the whole depth locally.
+  if (pCompartment->gridDepth() > 1)
+    {
+      mOrigin = repast::Point< int >(mOrigin[0], mOrigin[1], 0);
+      mShape = repast::Point< int >(mShape[0], mShape[1], pCompartment->gridDepth());
+    }
+
+  mHalo = halo(mShape, pCompartment->diffuserRefinement());
+  initEdges();
+
+  mpLocalValues[0] = new LocalValues(mShape, mValueSize, mHalo, std::numeric_limits< double >::quiet_NaN());
+  mpLocalValues[1] = new LocalValues(*mpLocalValues[0]);
 }
 
 SharedValueLayer::SharedValueLayer(const int & id, const int & startProc, const int & agentType, const int & currentProc, const int & state,
-                                   const repast::Point< int > & origin, const SharedValueLayer::BufferValues & bufferValues):
+                                   const repast::Point< int > & origin, const SharedValueLayer::BufferValues & bufferValues,
+                                   const std::vector< size_t > & planes):
   Agent(id, startProc, agentType, currentProc, state),
-  mValueSize(bufferValues.find(std::vector< int>(2, 0))->second.size()),
+  mValueSize(0),
   mOrigin(origin),
   mShape(0, 0),
-  mpLocalValues(NULL),
-  mBufferValues(bufferValues)
+  mHalo(1),
+  mEdges(),
+  mpLocalValues(),
+  mCurrent(0),
+  mBufferValues(bufferValues),
+  mSecretions(),
+  mExchangedPlanes(planes)
 {
-  const repast::GridDimensions & GridDimensions = Compartment::instance((Compartment::Type) state)->localGridDimensions();
+  mpLocalValues[0] = mpLocalValues[1] = NULL;
+
+  const Compartment * pCompartment = Compartment::instance((Compartment::Type) state);
+  const repast::GridDimensions & GridDimensions = pCompartment->localDiffuserDimensions();
 
   mShape[0] = round(GridDimensions.extents(0));
   mShape[1] = round(GridDimensions.extents(1));
+
+  if (pCompartment->gridDepth() > 1)
+    {
+      mShape = repast::Point< int >(mShape[0], mShape[1], pCompartment->gridDepth());
+    }
+
+  // All processes have local grids of the same shape, i.e., the layout of the buffer values is known.
+  mValueSize = pCompartment->getCytokines().size();
+  mHalo = halo(mShape, pCompartment->diffuserRefinement());
+  initEdges();
+}
+
+// static
+int SharedValueLayer::halo(const repast::Point< int > & shape, const int & refinement)
+{
+  // The width of the ghost ring determines how many diffusion steps may be done between synchronizations.
+  int Halo = 1;
+
+  if (!Properties::instance(Properties::run)->getValue("diffuser.halo", Halo) ||
+      Halo < 1)
+    {
+      Halo = 1;
+    }
+
+  // On a finer cytokine grid the agent cells adjacent to the local grid cover refinement ghost layers.
+  Halo = std::max(Halo, refinement);
+
+  // The neighbors must be able to provide the ghost cells.
+  for (size_t i = 0; i < shape.dimensionCount(); ++i)
+    {
+      Halo = std::min(Halo, shape[i]);
+    }
+
+  return Halo;
+}
+
+void SharedValueLayer::initEdges()
+{
+  const int & nx = mShape[0];
+  const int & ny = mShape[1];
+
+  // The edges are disjoint even if the frame covers the whole local grid.
+  int SouthEnd = std::min(mHalo, ny);
+  int NorthBegin = std::max(SouthEnd, ny - mHalo);
+  int WestEnd = std::min(mHalo, nx);
+  int EastBegin = std::max(WestEnd, nx - mHalo);
+
+  Edge South = {0, 0, nx, SouthEnd, 0};
+  Edge North = {0, NorthBegin, nx, ny - NorthBegin, 0};
+  Edge West = {0, SouthEnd, WestEnd, NorthBegin - SouthEnd, 0};
+  Edge East = {EastBegin, SouthEnd, nx - EastBegin, NorthBegin - SouthEnd, 0};
+
+  mEdges.clear();
+  mEdges.push_back(South);
+  mEdges.push_back(North);
+  mEdges.push_back(West);
+  mEdges.push_back(East);
+
+  size_t Start = 0;
+
+  for (std::vector< Edge >::iterator it = mEdges.begin(); it != mEdges.end(); ++it)
+    {
+      it->start = Start;
+      Start += it->width * it->height;
+    }
+}
+
+size_t SharedValueLayer::exchangedPlaneCount() const
+{
+  return mExchangedPlanes.empty() ? mValueSize : mExchangedPlanes.size();
+}
+
+size_t SharedValueLayer::bufferSize() const
+{
+  const Edge & Last = mEdges.back();
+  const int Depth = (mShape.dimensionCount() > 2) ? mShape[2] : 1;
+
+  return (Last.start + Last.width * Last.height) * exchangedPlaneCount() * Depth;
+}
+
+ptrdiff_t SharedValueLayer::bufferIndex(const size_t & position, const int & x, const int & y, const int & z, int & count) const
+{
+  const int Depth = (mShape.dimensionCount() > 2) ? mShape[2] : 1;
+  std::vector< Edge >::const_iterator it = mEdges.begin();
+  std::vector< Edge >::const_iterator end = mEdges.end();
+
+  for (; it != end; ++it)
+    {
+      if (it->x <= x && x < it->x + it->width &&
+          it->y <= y && y < it->y + it->height)
+        {
+          count = it->x + it->width - x;
+
+          return it->start * exchangedPlaneCount() * Depth
+                 + ((position * Depth + z) * it->height + y - it->y) * it->width + x - it->x;
+        }
+    }
+
+  count = 0;
+
+  return -1;
 }
 
 SharedValueLayer::~SharedValueLayer()
 {
-  if (mpLocalValues != NULL) delete mpLocalValues;
+  if (mpLocalValues[0] != NULL) delete mpLocalValues[0];
+  if (mpLocalValues[1] != NULL) delete mpLocalValues[1];
 }
 
 // virtual
@@ -65,76 +197,152 @@ void SharedValueLayer::write(std::ostream & o, const std::string & separator, Co
   std::vector< Cytokine * >::const_iterator itCytokine = pCompartment->getCytokines().begin();
   std::vector< Cytokine * >::const_iterator endCytokine = pCompartment->getCytokines().end();
 
+  const int Depth = (mShape.dimensionCount() > 2) ? mShape[2] : 1;
+
   for (int k = 0; itCytokine != endCytokine; ++itCytokine, ++k)
     {
 #ifdef DEBUG_SHARED
-      repast::Point< int > Origin(0, 0);
-      repast::Point< int > Shape(mShape[0] + 2, mShape[1] + 2);
+      const int & Halo = mpLocalValues[mCurrent]->halo();
+      repast::Point< int > Origin(-Halo, -Halo);
+      repast::Point< int > Shape(mShape[0] + 2 * Halo, mShape[1] + 2 * Halo);
 #else
-      repast::Point< int > Origin(1, 1);
+      repast::Point< int > Origin(0, 0);
       repast::Point< int > Shape(mShape[0], mShape[1]);
 #endif
 
       o << (*itCytokine)->getName() << std::endl;
 
-      for (int i = Origin[0], imax = Shape[0]; i < imax; ++i)
+      for (int z = 0; z < Depth; ++z)
         {
-          o << separator << Dimensions.origin(0) + (i - 1) * delta;
-        }
-
-      o << std::endl;
+          if (Depth > 1)
+            {
+              o << "z" << separator << z << std::endl;
+            }
 
-      Iterator itPoint(Origin, Shape);
+          for (int i = Origin[0], imax = Origin[0] + Shape[0]; i < imax; ++i)
+            {
+              o << separator << Dimensions.origin(0) + i * delta;
+            }
 
-      for (int j = Origin[1], jmax = Shape[1]; j < jmax; ++j)
-        {
-          o << Dimensions.origin(1) + (j - 1) * delta;
+          o << std::endl;
 
-          for (int i = Origin[0], imax = Shape[0]; i < imax; ++i, itPoint.next())
+          for (int j = Origin[1], jmax = Origin[1] + Shape[1]; j < jmax; ++j)
             {
-              o << separator << mpLocalValues->operator[](*itPoint)[k];
+              o << Dimensions.origin(1) + j * delta;
+
+              const double * pValue = mpLocalValues[mCurrent]->row(k, j, z) + Origin[0];
+
+              for (int i = 0, imax = Shape[0]; i < imax; ++i, ++pValue)
+                {
+                  o << separator << *pValue;
+                }
+
+              o << std::endl;
             }
 
           o << std::endl;
         }
+    }
+}
 
-      o << std::endl;
+void SharedValueLayer::secrete(const size_t & index, const repast::Point< int > & location, const double & amount)
+{
+  std::vector< double > & Secretion = mSecretions[location.coords()];
+
+  if (Secretion.empty())
+    {
+      Secretion.resize(mValueSize, 0.0);
     }
+
+  Secretion[index] += amount;
 }
 
-bool SharedValueLayer::contains(const repast::Point< int > & pt) const
+const SharedValueLayer::Secretions & SharedValueLayer::getSecretions() const
+{
+  return mSecretions;
+}
+
+void SharedValueLayer::setSecretions(const Secretions & secretions)
+{
+  mSecretions = secretions;
+}
+
+void SharedValueLayer::clearSecretions()
+{
+  mSecretions.clear();
+}
+
+void SharedValueLayer::setExchangedPlanes(const std::vector< size_t > & planes)
+{
+  mExchangedPlanes = planes;
+}
+
+const std::vector< size_t > & SharedValueLayer::getExchangedPlanes() const
 {
-  return mOrigin[0] - 1 <= pt[0]
-         && pt[0] < mOrigin[0] + mShape[0] + 1
-         && mOrigin[1] - 1 <= pt[1]
-         && pt[1] < mOrigin[1] + mShape[1] + 1;
+  return mExchangedPlanes;
 }
 
+bool SharedValueLayer::owns(const repast::Point< int > & pt) const
+{
+  return mOrigin[0] <= pt[0]
+         && pt[0] < mOrigin[0] + mShape[0]
+         && mOrigin[1] <= pt[1]
+         && pt[1] < mOrigin[1] + mShape[1];
+}
 
-std::vector< double > & SharedValueLayer::operator[](const repast::Point< int > location)
+bool SharedValueLayer::contains(const repast::Point< int > & pt) const
 {
+  const int Halo = (mpLocalValues[mCurrent] != NULL) ? mpLocalValues[mCurrent]->halo() : 1;
+
+  return mOrigin[0] - Halo <= pt[0]
+         && pt[0] < mOrigin[0] + mShape[0] + Halo
+         && mOrigin[1] - Halo <= pt[1]
+         && pt[1] < mOrigin[1] + mShape[1] + Halo;
+}
+
 
-  if (mpLocalValues != NULL)
+double & SharedValueLayer::operator()(const size_t & index, const repast::Point< int > & location)
+{
+  if (mpLocalValues[mCurrent] != NULL)
     {
-      return mpLocalValues->operator[](repast::Point< int >(location[0] - mOrigin[0] + 1, location[1] - mOrigin[1] + 1));
+      return mpLocalValues[mCurrent]->operator()(index, location[0] - mOrigin[0], location[1] - mOrigin[1]);
     }
 
   throw std::runtime_error("cytokine value not found: no local values defined");
 
-  static std::vector< double > NaN(mShape.dimensionCount(), std::numeric_limits< double >::quiet_NaN());
+  static double NaN = std::numeric_limits< double >::quiet_NaN();
   return NaN;
 }
 
-std::vector< double > * SharedValueLayer::tryLocation(const repast::Point< int > location)
+double * SharedValueLayer::tryLocation(const size_t & index, const repast::Point< int > & location)
 {
-  BufferValues::iterator found = mBufferValues.find(repast::Point< int >(location[0] - mOrigin[0], location[1] - mOrigin[1]).coords());
+  size_t Position = index;
 
-  if (found != mBufferValues.end())
+  if (!mExchangedPlanes.empty())
     {
-      return &found->second;
+      Position = std::find(mExchangedPlanes.begin(), mExchangedPlanes.end(), index) - mExchangedPlanes.begin();
+
+      if (Position == mExchangedPlanes.size()) return NULL;
     }
 
-  return NULL;
+  // The agents are located in the layer z = 0.
+  int Count;
+  ptrdiff_t Index = bufferIndex(Position, location[0] - mOrigin[0], location[1] - mOrigin[1], 0, Count);
+
+  if (Index < 0 ||
+      (size_t) Index >= mBufferValues.size())
+    {
+      return NULL;
+    }
+
+  return &mBufferValues[Index];
+}
+
+bool SharedValueLayer::buffers(const repast::Point< int > & location) const
+{
+  int Count;
+
+  return bufferIndex(0, location[0] - mOrigin[0], location[1] - mOrigin[1], 0, Count) >= 0;
 }
 
 const repast::Point< int > & SharedValueLayer::origin() const
@@ -149,7 +357,17 @@ const repast::Point< int > & SharedValueLayer::shape() const
 
 SharedValueLayer::LocalValues * SharedValueLayer::getLocalValues()
 {
-  return mpLocalValues;
+  return mpLocalValues[mCurrent];
+}
+
+SharedValueLayer::LocalValues * SharedValueLayer::getNextValues()
+{
+  return mpLocalValues[1 - mCurrent];
+}
+
+void SharedValueLayer::flipLocalValues()
+{
+  mCurrent = 1 - mCurrent;
 }
 
 void SharedValueLayer::getBufferValues(repast::Point< int > & origin,
@@ -157,62 +375,87 @@ void SharedValueLayer::getBufferValues(repast::Point< int > & origin,
 
 {
   origin = mOrigin;
+  bufferValues.resize(bufferSize());
 
-  // North border
-  repast::Point< int > LocalIndex(1, 1);
-  std::vector< int > RemoteIndex(2, 0);
-
-  for (size_t i = 0, imax = mShape[0]; i < imax; ++i, LocalIndex[0]++, RemoteIndex[0]++)
+  if (!bufferValues.empty())
     {
-      bufferValues[RemoteIndex] = mpLocalValues->operator[](LocalIndex);
+      copyBufferValues(&bufferValues[0]);
     }
+}
 
-  // South border
-  LocalIndex = repast::Point< int >(1, mShape[1]);
-  RemoteIndex = repast::Point< int >(0, mShape[1] - 1).coords();
+void SharedValueLayer::copyBufferValues(double * pBufferValues) const
+{
+  // The neighbors need the frame of width halo along the north, south, east, and west borders.
+  // Cytokine slabs provide the frame for each layer. Each row of an edge is contiguous in the
+  // local values and in the buffer.
+  const LocalValues & Values = *mpLocalValues[mCurrent];
+  const int Depth = (mShape.dimensionCount() > 2) ? mShape[2] : 1;
+  const size_t Planes = exchangedPlaneCount();
 
-  for (size_t i = 0, imax = mShape[0]; i < imax; ++i, LocalIndex[0]++, RemoteIndex[0]++)
-    {
-      bufferValues[RemoteIndex] = mpLocalValues->operator[](LocalIndex);
-    }
+  std::vector< Edge >::const_iterator it = mEdges.begin();
+  std::vector< Edge >::const_iterator end = mEdges.end();
 
-  // East border
-  LocalIndex = repast::Point< int >(1, 1);
-  RemoteIndex = repast::Point< int >(0, 0).coords();
+  for (; it != end; ++it)
+    for (size_t i = 0; i < Planes; ++i)
+      for (int z = 0; z < Depth; ++z)
+        for (int y = it->y, ymax = it->y + it->height; y < ymax; ++y)
+          {
+            const size_t k = mExchangedPlanes.empty() ? i : mExchangedPlanes[i];
+            int Count;
+            ptrdiff_t Index = bufferIndex(i, it->x, y, z, Count);
+
+            memcpy(pBufferValues + Index, Values.row(k, y, z) + it->x, it->width * sizeof(double));
+          }
+}
 
-  for (size_t i = 0, imax = mShape[1]; i < imax; ++i, LocalIndex[1]++, RemoteIndex[1]++)
-    {
-      bufferValues[RemoteIndex] = mpLocalValues->operator[](LocalIndex);
-    }
+/**
+ * The ghost cells [begin, end) are provided by the neighbor's cells [begin + shift, end + shift)
+ */
+struct GhostRange
+{
+  int begin;
+  int end;
+  int shift;
+};
 
-  // West border
-  LocalIndex = repast::Point< int >(mShape[0], 1);
-  RemoteIndex = repast::Point< int >(mShape[0] - 1, 0).coords();
+static void ghostRanges(const Borders::BoundState & boundState, const int & shape, const int & halo,
+                        std::vector< GhostRange > & ranges)
+{
+  ranges.clear();
+  GhostRange Range;
 
-  for (size_t i = 0, imax = mShape[1]; i < imax; ++i, LocalIndex[1]++, RemoteIndex[1]++)
+  if (boundState == Borders::OUT_LOW ||
+      boundState == Borders::OUT_BOTH)
     {
-      bufferValues[RemoteIndex] = mpLocalValues->operator[](LocalIndex);
+      Range.begin = -halo;
+      Range.end = 0;
+      Range.shift = shape;
+      ranges.push_back(Range);
     }
-}
 
-void SharedValueLayer::updateBufferValues(const SharedValueLayer & neighbor,
-    const Borders & globalBorders)
-{
-
-  const repast::Point< int > & origin = neighbor.mOrigin;
-  const BufferValues & bufferValues = neighbor.mBufferValues;
-
-  // LocalFile::debug() << "receiving: " << origin << std::endl;
-  BufferValues::const_iterator it = bufferValues.begin();
-  BufferValues::const_iterator end = bufferValues.end();
+  if (boundState == Borders::INBOUND)
+    {
+      Range.begin = 0;
+      Range.end = shape;
+      Range.shift = 0;
+      ranges.push_back(Range);
+    }
 
-  for (; it != end; ++it)
+  if (boundState == Borders::OUT_HIGH ||
+      boundState == Borders::OUT_BOTH)
     {
-       // LocalFile::debug() << origin[0] + it->first[0] << ", " << origin[1] + it->first[1] << std::endl;
+      Range.begin = shape;
+      Range.end = shape + halo;
+      Range.shift = -shape;
+      ranges.push_back(Range);
     }
+}
 
-  // Currently only 2D
-  std::vector<Borders::BoundState> BoundState(2, Borders::INBOUND);
+bool SharedValueLayer::boundStates(const repast::Point< int > & origin, const Borders & globalBorders,
+                                   std::vector< Borders::BoundState > & boundState) const
+{
+  // Only x and y are distributed
+  boundState.assign(2, Borders::INBOUND);
 
   std::vector< int > OutLow(2, 0);
   std::vector< int > OutHigh(2, 0);
@@ -223,146 +466,172 @@ void SharedValueLayer::updateBufferValues(const SharedValueLayer & neighbor,
     {
       if (origin[i] == mOrigin[i])
         {
-          BoundState[i] = Borders::INBOUND;
+          boundState[i] = Borders::INBOUND;
         }
       else if (origin[i] == OutLow[i] &&
                origin[i] == OutHigh[i])
         {
-          BoundState[i] = Borders::OUT_BOTH;
+          boundState[i] = Borders::OUT_BOTH;
         }
       else if (origin[i] == OutLow[i])
         {
-          BoundState[i] = Borders::OUT_LOW;
+          boundState[i] = Borders::OUT_LOW;
         }
       else if (origin[i] == OutHigh[i])
         {
-          BoundState[i] = Borders::OUT_HIGH;
+          boundState[i] = Borders::OUT_HIGH;
         }
       else
         {
           // The provided information is not needed!
-          return;
+          return false;
         }
     }
 
-  repast::Point< int > LocalIndex(1, 1);
-  std::vector< int > RemoteIndex(2, 0);
+  // Local information is never changed
+  return boundState[0] != Borders::INBOUND ||
+         boundState[1] != Borders::INBOUND;
+}
 
-  if (BoundState[0] == Borders::OUT_LOW ||
-      BoundState[0] == Borders::OUT_BOTH)
-    {
-      LocalIndex[0] = 0;
-      RemoteIndex[0] = mShape[0] - 1;
+void SharedValueLayer::ghostSources(const repast::Point< int > & origin, const Borders & globalBorders,
+                                    std::vector< Rectangle > & cells) const
+{
+  cells.clear();
 
-      if (BoundState[1] == Borders::OUT_LOW ||
-          BoundState[1] == Borders::OUT_BOTH)
-        {
-          LocalIndex[1] = 0;
-          RemoteIndex[1] = mShape[1] - 1;
+  std::vector< Borders::BoundState > BoundState;
 
-          mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-        }
+  if (!boundStates(origin, globalBorders, BoundState)) return;
 
-      if (BoundState[1] == Borders::INBOUND)
-        {
-          LocalIndex[1] = 1;
-          RemoteIndex[1] = 0;
+  const int & Halo = mpLocalValues[mCurrent]->halo();
 
-          for (size_t i = 0, imax = mShape[1]; i < imax; ++i, LocalIndex[1]++, RemoteIndex[1]++)
-            {
-              mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-            }
-        }
+  std::vector< GhostRange > RangesX;
+  ghostRanges(BoundState[0], mShape[0], Halo, RangesX);
 
-      if (BoundState[1] == Borders::OUT_HIGH ||
-          BoundState[1] == Borders::OUT_BOTH)
-        {
-          LocalIndex[1] = mShape[1] + 1;
-          RemoteIndex[1] = 0;
+  std::vector< GhostRange > RangesY;
+  ghostRanges(BoundState[1], mShape[1], Halo, RangesY);
 
-          mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-        }
-    }
+  std::vector< GhostRange >::const_iterator itX;
+  std::vector< GhostRange >::const_iterator endX = RangesX.end();
+  std::vector< GhostRange >::const_iterator itY;
+  std::vector< GhostRange >::const_iterator endY = RangesY.end();
 
-  if (BoundState[0] == Borders::INBOUND)
-    {
-      LocalIndex[0] = 1;
-      RemoteIndex[0] = 0;
+  for (itX = RangesX.begin(); itX != endX; ++itX)
+    for (itY = RangesY.begin(); itY != endY; ++itY)
+      {
+        Rectangle Cells = {itX->begin + itX->shift, itY->begin + itY->shift, itX->end - itX->begin, itY->end - itY->begin};
+        cells.push_back(Cells);
+      }
+}
 
-      if (BoundState[1] == Borders::OUT_LOW ||
-          BoundState[1] == Borders::OUT_BOTH)
-        {
-          LocalIndex[1] = 0;
-          RemoteIndex[1] = mShape[1] - 1;
+void SharedValueLayer::bufferSegments(const std::vector< Rectangle > & cells, Segments & segments) const
+{
+  segments.clear();
+
+  const int Depth = (mShape.dimensionCount() > 2) ? mShape[2] : 1;
+  const size_t Planes = exchangedPlaneCount();
+  const size_t Size = bufferSize();
+
+  std::vector< Rectangle >::const_iterator it;
+  std::vector< Rectangle >::const_iterator end = cells.end();
 
-          for (size_t i = 0, imax = mShape[0]; i < imax; ++i, LocalIndex[0]++, RemoteIndex[0]++)
+  // The order of the segments is the same for the sender and the receiver. Adjacent segments are merged.
+  for (size_t i = 0; i < Planes; ++i)
+    for (int z = 0; z < Depth; ++z)
+      for (it = cells.begin(); it != end; ++it)
+        for (int y = it->y, ymax = it->y + it->height; y < ymax; ++y)
+          for (int x = it->x, xmax = it->x + it->width; x < xmax;)
             {
-              mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
+              int Count;
+              ptrdiff_t Index = bufferIndex(i, x, y, z, Count);
+
+              if (Index < 0 ||
+                  (size_t) Index >= Size)
+                {
+                  ++x;
+                  continue;
+                }
+
+              Count = std::min(Count, xmax - x);
+
+              if (!segments.empty() &&
+                  segments.back().first + segments.back().second == (size_t) Index)
+                {
+                  segments.back().second += Count;
+                }
+              else
+                {
+                  segments.push_back(std::make_pair((size_t) Index, (size_t) Count));
+                }
+
+              x += Count;
             }
-        }
+}
 
-      if (BoundState[1] == Borders::INBOUND)
-        {
-          // Local information is never changed
-          return;
-        }
+void SharedValueLayer::updateBufferValues(const SharedValueLayer & neighbor,
+    const Borders & globalBorders)
+{
 
-      if (BoundState[1] == Borders::OUT_HIGH ||
-          BoundState[1] == Borders::OUT_BOTH)
-        {
-          LocalIndex[1] = mShape[1] + 1;
-          RemoteIndex[1] = 0;
+  const BufferValues & bufferValues = neighbor.mBufferValues;
 
-          for (size_t i = 0, imax = mShape[0]; i < imax; ++i, LocalIndex[0]++, RemoteIndex[0]++)
-            {
-              mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-            }
-        }
-    }
+  std::vector< Borders::BoundState > BoundState;
 
-  if (BoundState[0] == Borders::OUT_HIGH ||
-      BoundState[0] == Borders::OUT_BOTH)
-    {
-      LocalIndex[0] = mShape[0] + 1;
-      RemoteIndex[0] = 0;
+  if (!boundStates(neighbor.mOrigin, globalBorders, BoundState)) return;
 
-      if (BoundState[1] == Borders::OUT_LOW ||
-          BoundState[1] == Borders::OUT_BOTH)
-        {
-          LocalIndex[1] = 0;
-          RemoteIndex[1] = mShape[1] - 1;
+  const int & Halo = mpLocalValues[mCurrent]->halo();
 
-          mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-        }
-      else if (BoundState[1] == Borders::INBOUND)
-        {
-          LocalIndex[1] = 1;
-          RemoteIndex[1] = 0;
+  std::vector< GhostRange > RangesX;
+  ghostRanges(BoundState[0], mShape[0], Halo, RangesX);
 
-          for (size_t i = 0, imax = mShape[1]; i < imax; ++i, LocalIndex[1]++, RemoteIndex[1]++)
-            {
-              mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-            }
+  std::vector< GhostRange > RangesY;
+  ghostRanges(BoundState[1], mShape[1], Halo, RangesY);
 
-          return;
-        }
-      else if (BoundState[1] == Borders::OUT_HIGH ||
-               BoundState[1] == Borders::OUT_BOTH)
-        {
-          LocalIndex[1] = mShape[1] + 1;
-          RemoteIndex[1] = 0;
+  std::vector< GhostRange >::const_iterator itX;
+  std::vector< GhostRange >::const_iterator endX = RangesX.end();
+  std::vector< GhostRange >::const_iterator itY;
+  std::vector< GhostRange >::const_iterator endY = RangesY.end();
 
-          mpLocalValues->operator[](LocalIndex) = bufferValues.find(RemoteIndex)->second;
-        }
-    }
+  // The depth of cytokine slabs is not distributed, i.e., each layer is provided by the neighbor.
+  // The ghost rows are copied in segments which are contiguous in the neighbor's edges.
+  const int Depth = (mShape.dimensionCount() > 2) ? mShape[2] : 1;
+  const size_t Planes = neighbor.exchangedPlaneCount();
+  LocalValues & Values = *mpLocalValues[mCurrent];
+
+  for (size_t i = 0; i < Planes; ++i)
+    for (int z = 0; z < Depth; ++z)
+      for (itX = RangesX.begin(); itX != endX; ++itX)
+        for (itY = RangesY.begin(); itY != endY; ++itY)
+          for (int y = itY->begin; y < itY->end; ++y)
+            {
+              const size_t k = neighbor.mExchangedPlanes.empty() ? i : neighbor.mExchangedPlanes[i];
+              double * pRow = Values.row(k, y, z);
+
+              for (int x = itX->begin; x < itX->end;)
+                {
+                  int Count;
+                  ptrdiff_t Index = neighbor.bufferIndex(i, x + itX->shift, y + itY->shift, z, Count);
+
+                  if (Index < 0 ||
+                      (size_t) Index >= bufferValues.size())
+                    {
+                      ++x;
+                      continue;
+                    }
+
+                  Count = std::min(Count, itX->end - x);
+                  memcpy(pRow + x, &bufferValues[Index], Count * sizeof(double));
+                  x += Count;
+                }
+            }
 }
 
 void SharedValueLayer::completeBufferValues(const Borders & globalBorders)
 {
-  // Currently only 2D
-  repast::Point< int > Origin(0, 0);
-  repast::Point< int > Shape(mShape[0] + 2, mShape[1] + 2);
-
+  // Only x and y are distributed
+  // The ghost ring holds the boundary values after this call, i.e., the diffuser does not need to
+  // check for boundaries. Borders of the type REFLECT, STICKY, and PERMIABLE are closed for cytokines
+  // and the ghost cells mirror the adjacent interior cells (zero flux). WRAP borders are provided
+  // by the neighbor unless we are our own neighbor, i.e., the local grid spans the whole dimension.
+  // The top and bottom of cytokine slabs are closed.
   std::vector< int > Low(2, 0);
   Low[Borders::X] = mOrigin[Borders::X];
   Low[Borders::Y] = mOrigin[Borders::Y];
@@ -371,89 +640,114 @@ void SharedValueLayer::completeBufferValues(const Borders & globalBorders)
   High[Borders::X] = mOrigin[Borders::X] + mShape[Borders::X] - 1;
   High[Borders::Y] = mOrigin[Borders::Y] + mShape[Borders::Y] - 1;
 
-  // TODO CRITICAL It is possible that we have WRAP and we are our own neighbor.
+  LocalValues & Values = *mpLocalValues[mCurrent];
+  const int & Halo = Values.halo();
+  const int & nx = mShape[Borders::X];
+  const int & ny = mShape[Borders::Y];
+  const int nz = (mShape.dimensionCount() > 2) ? mShape[Borders::Z] : 1;
+
+  bool WrapX = globalBorders.getBorderType(Borders::X, Borders::LOW) == Borders::WRAP &&
+               nx == round(globalBorders.dimensions().extents(Borders::X));
+  bool WrapY = globalBorders.getBorderType(Borders::Y, Borders::LOW) == Borders::WRAP &&
+               ny == round(globalBorders.dimensions().extents(Borders::Y));
+
+  // The columns are completed first including the corners as these may be provided by the north or south neighbor.
+  if (WrapX)
+    {
+      for (int z = 0; z < nz; ++z)
+        for (int y = -Halo, ymax = ny + Halo; y < ymax; y++)
+          for (int i = 1; i <= Halo; ++i)
+            {
+              Values.copyCell(-i, y, nx - i, y, z);
+              Values.copyCell(nx - 1 + i, y, i - 1, y, z);
+            }
+    }
 
   if (globalBorders.getBorderType(Borders::X, Borders::LOW) != Borders::WRAP &&
       globalBorders.distanceFromBorder(Low, Borders::X, Borders::LOW) < 0.5)
     {
-      std::vector< int > Boundary(2, 0);
-      Boundary[Borders::X] = 0;
-      Boundary[Borders::Y] = 0;
-
-      std::vector< int > Value(2, 0);
-      Value[Borders::X] = 1;
-      Value[Borders::Y] = 0;
-
-      size_t i = 0, imax = Shape[Borders::Y];
-
-      for (; i < imax; i++, Boundary[Borders::Y]++, Value[Borders::Y]++)
-        {
-          mpLocalValues->operator [](Boundary) = mpLocalValues->operator [](Value);
-        }
+      for (int z = 0; z < nz; ++z)
+        for (int y = -Halo, ymax = ny + Halo; y < ymax; y++)
+          for (int i = 1; i <= Halo; ++i)
+            {
+              Values.copyCell(-i, y, i - 1, y, z);
+            }
     }
 
   if (globalBorders.getBorderType(Borders::X, Borders::HIGH) != Borders::WRAP &&
       globalBorders.distanceFromBorder(High, Borders::X, Borders::HIGH) < 1.5)
     {
-      std::vector< int > Boundary(2, 0);
-      Boundary[Borders::X] = Shape[Borders::X] - 1;
-      Boundary[Borders::Y] = 0;
-
-      std::vector< int > Value(2, 0);
-      Value[Borders::X] =  Shape[Borders::X] - 2;
-      Value[Borders::Y] = 0;
+      for (int z = 0; z < nz; ++z)
+        for (int y = -Halo, ymax = ny + Halo; y < ymax; y++)
+          for (int i = 1; i <= Halo; ++i)
+            {
+              Values.copyCell(nx - 1 + i, y, nx - i, y, z);
+            }
+    }
 
-      size_t i = 0, imax = Shape[Borders::Y];
+  // The rows including the corners are contiguous in each plane.
+  size_t Count = (nx + 2 * Halo) * sizeof(double);
 
-      for (; i < imax; i++, Boundary[Borders::Y]++, Value[Borders::Y]++)
-        {
-          mpLocalValues->operator [](Boundary) = mpLocalValues->operator [](Value);
-        }
+  if (WrapY)
+    {
+      for (size_t k = 0; k < mValueSize; ++k)
+        for (int z = 0; z < nz; ++z)
+          for (int i = 1; i <= Halo; ++i)
+            {
+              memcpy(Values.row(k, -i, z) - Halo, Values.row(k, ny - i, z) - Halo, Count);
+              memcpy(Values.row(k, ny - 1 + i, z) - Halo, Values.row(k, i - 1, z) - Halo, Count);
+            }
     }
 
   if (globalBorders.getBorderType(Borders::Y, Borders::LOW) != Borders::WRAP &&
       globalBorders.distanceFromBorder(Low, Borders::Y, Borders::LOW) < 0.5)
     {
-      std::vector< int > Boundary(2, 0);
-      Boundary[Borders::X] = 0;
-      Boundary[Borders::Y] = 0;
-
-      std::vector< int > Value(2, 0);
-      Value[Borders::X] = 0;
-      Value[Borders::Y] = 1;
-
-      size_t i = 0, imax = Shape[Borders::X];
-
-      for (; i < imax; i++, Boundary[Borders::X]++, Value[Borders::X]++)
-        {
-          mpLocalValues->operator [](Boundary) = mpLocalValues->operator [](Value);
-        }
+      for (size_t k = 0; k < mValueSize; ++k)
+        for (int z = 0; z < nz; ++z)
+          for (int i = 1; i <= Halo; ++i)
+            {
+              memcpy(Values.row(k, -i, z) - Halo, Values.row(k, i - 1, z) - Halo, Count);
+            }
     }
 
   if (globalBorders.getBorderType(Borders::Y, Borders::HIGH) != Borders::WRAP &&
       globalBorders.distanceFromBorder(High, Borders::Y, Borders::HIGH) < 1.5)
     {
-      std::vector< int > Boundary(2, 0);
-      Boundary[Borders::X] = 0;
-      Boundary[Borders::Y] = Shape[Borders::Y] - 1;
-
-      std::vector< int > Value(2, 0);
-      Value[Borders::X] = 0;
-      Value[Borders::Y] = Shape[Borders::Y] - 2;
-
-      size_t i = 0, imax = Shape[Borders::X];
+      for (size_t k = 0; k < mValueSize; ++k)
+        for (int z = 0; z < nz; ++z)
+          for (int i = 1; i <= Halo; ++i)
+            {
+              memcpy(Values.row(k, ny - 1 + i, z) - Halo, Values.row(k, ny - i, z) - Halo, Count);
+            }
+    }
 
-      for (; i < imax; i++, Boundary[Borders::X]++, Value[Borders::X]++)
-        {
-          mpLocalValues->operator [](Boundary) = mpLocalValues->operator [](Value);
-        }
+  // The layers above and below the slab mirror the top and bottom layers including their ghost rings.
+  if (nz > 1)
+    {
+      for (size_t k = 0; k < mValueSize; ++k)
+        for (int i = 1; i <= Halo; ++i)
+          for (int y = -Halo, ymax = ny + Halo; y < ymax; y++)
+            {
+              memcpy(Values.row(k, y, -i) - Halo, Values.row(k, y, i - 1) - Halo, Count);
+              memcpy(Values.row(k, y, nz - 1 + i) - Halo, Values.row(k, y, nz - i) - Halo, Count);
+            }
     }
 }
 
 void SharedValueLayer::setBufferValues(const repast::Point< int > & origin,
-                                       const BufferValues & bufferValues)
+                                       const BufferValues & bufferValues,
+                                       const std::vector< size_t > & planes)
 {
   assert(mOrigin == origin);
 
   mBufferValues = bufferValues;
+  mExchangedPlanes = planes;
+}
+
+SharedValueLayer::BufferValues & SharedValueLayer::resizeBufferValues(const std::vector< size_t > & planes)
+{
+  mExchangedPlanes = planes;
+  mBufferValues.resize(bufferSize());
+
+  return mBufferValues;
 }
@@ -14,7 +14,7 @@
 
 #include "grid/ValueLayer.h"
 #include "grid/Borders.h"
-#include "grid/matrix.h"
+#include "grid/ValuePlanes.h"
 
 namespace ENISI
 {
@@ -25,8 +25,29 @@ private:
   SharedValueLayer();
 
 public:
-  typedef DenseMatrix< std::vector< double > > LocalValues;
-  typedef std::map< std::vector< int >, std::vector< double > > BufferValues;
+  typedef ValuePlanes LocalValues;
+
+  /**
+   * The buffer values hold the frame of width halo of the local grid, which the neighbors need for their
+   * ghost cells. The frame is split into the disjoint edges South and North (full rows including the
+   * corners), West, and East, which are stored contiguously in this order. Within an edge the values
+   * are ordered by exchanged plane, layer (z), row (y), and column (x).
+   */
+  typedef std::vector< double > BufferValues;
+  typedef std::map< std::vector< int >, std::vector< double > > Secretions;
+
+  /**
+   * A rectangle of cells of a local grid and the segments [first, first + second) of buffer values
+   */
+  struct Rectangle
+  {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  typedef std::vector< std::pair< size_t, size_t > > Segments;
 
   /**
    * @param const Type & type (Valid values: Agent::DiffuserValues)
@@ -35,7 +56,7 @@ public:
   SharedValueLayer(const Type & type, const int & compartmentType, const size_t & valueSize);
 
   SharedValueLayer(const int & id, const int & startProc, const int & agentType, const int & currentProc, const int & state,
-                   const repast::Point< int > & origin, const BufferValues & bufferValues);
+                   const repast::Point< int > & origin, const BufferValues & bufferValues, const std::vector< size_t > & planes);
 
   virtual ~SharedValueLayer();
 
@@ -44,30 +65,124 @@ public:
   void getBufferValues(repast::Point< int > & origin,
                        BufferValues & bufferValues) const;
 
+  /**
+   * Write the buffer values to pBufferValues, which must hold at least getBufferValues' count of values.
+   */
+  void copyBufferValues(double * pBufferValues) const;
+
+  /**
+   * Set the buffer values of a neighbor, which hold the planes (empty for all planes).
+   */
   void setBufferValues(const repast::Point< int > & origin,
-                       const BufferValues & bufferValues);
+                       const BufferValues & bufferValues,
+                       const std::vector< size_t > & planes);
+
+  /**
+   * Set the exchanged planes of a neighbor and size its buffer values accordingly, i.e., the
+   * buffer values can be received in place.
+   */
+  BufferValues & resizeBufferValues(const std::vector< size_t > & planes);
 
   void updateBufferValues(const SharedValueLayer & neighbor,
                           const Borders & globalBorders);
 
   void completeBufferValues(const Borders & globalBorders);
 
+  /**
+   * The rectangles of the local grid of the neighbor at origin which provide our ghost cells. The result
+   * is empty if the neighbor is not adjacent.
+   */
+  void ghostSources(const repast::Point< int > & origin, const Borders & globalBorders,
+                    std::vector< Rectangle > & cells) const;
+
+  /**
+   * The segments of the buffer values holding the frame cells of the rectangles for the exchanged planes.
+   * Senders and receivers of a directional exchange determine the same segments, i.e., only the values
+   * of the segments need to be transferred.
+   */
+  void bufferSegments(const std::vector< Rectangle > & cells, Segments & segments) const;
+
+  /**
+   * The local values are double buffered, i.e., the diffuser writes the next values
+   * and flips the buffers instead of copying the values.
+   */
   LocalValues * getLocalValues();
+  LocalValues * getNextValues();
+  void flipLocalValues();
+
+  /**
+   * The secretions of the agents are accumulated per cell, where the key is the global location.
+   * They are exchanged with the buffer values and added to all copies of the cell by
+   * Compartment::synchronizeDiffuser, i.e., secretions into ghost cells reach the owner.
+   */
+  void secrete(const size_t & index, const repast::Point< int > & location, const double & amount);
+  const Secretions & getSecretions() const;
+  void setSecretions(const Secretions & secretions);
+  void clearSecretions();
 
+  /**
+   * Restrict the exchanged buffer values to the planes which changed, where an empty selection
+   * exchanges all planes. Until the next exchange of all planes the buffer values of the neighbors
+   * hold the selected planes only.
+   */
+  void setExchangedPlanes(const std::vector< size_t > & planes);
+  const std::vector< size_t > & getExchangedPlanes() const;
+
+  bool owns(const repast::Point< int > & pt) const;
   bool contains(const repast::Point< int > & pt) const;
-  std::vector< double > & operator[](const repast::Point< int > location);
-  std::vector< double > * tryLocation(const repast::Point< int > location);
+  double & operator()(const size_t & index, const repast::Point< int > & location);
+
+  /**
+   * The buffer value of the cytokine index at the global location (layer z = 0) or NULL if the
+   * location or the plane is not part of the buffer values.
+   */
+  double * tryLocation(const size_t & index, const repast::Point< int > & location);
+  bool buffers(const repast::Point< int > & location) const;
 
   const repast::Point< int > & origin() const;
   const repast::Point< int > & shape() const;
 
 protected:
+  struct Edge
+  {
+    int x;
+    int y;
+    int width;
+    int height;
+    size_t start;  // cells of the preceding edges per plane and layer
+  };
+
+  static int halo(const repast::Point< int > & shape, const int & refinement);
+
+  /**
+   * The position of the neighbor at origin relative to us in x and y, false if the neighbor does not
+   * provide any of our ghost cells.
+   */
+  bool boundStates(const repast::Point< int > & origin, const Borders & globalBorders,
+                   std::vector< Borders::BoundState > & boundState) const;
+
+  void initEdges();
+  size_t exchangedPlaneCount() const;
+  size_t bufferSize() const;
+
+  /**
+   * The index of the buffer value of the local cell (x, y, z) for the position of the plane among the
+   * exchanged planes, where count is the number of cells of the row which follow within the same edge.
+   * The result is -1 if the cell is not part of the frame.
+   */
+  ptrdiff_t bufferIndex(const size_t & position, const int & x, const int & y, const int & z, int & count) const;
+
   size_t mValueSize;
   repast::Point< int > mOrigin;
   repast::Point< int > mShape;
+  int mHalo;
+  std::vector< Edge > mEdges;
 
-  LocalValues * mpLocalValues;
+  LocalValues * mpLocalValues[2];
+  size_t mCurrent;
   BufferValues mBufferValues;
+  Secretions mSecretions;
+  std::vector< size_t > mExchangedPlanes;
 };
 
 
@@ -176,7 +176,7 @@ void TcellGroup::act(const repast::Point<int> & pt)
 				}
 				if (p_th17cyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
-					mpCompartment->cytokineValue("eIL17", pt) += 5;
+					mpCompartment->secrete("eIL17", pt, 5);
 				}
 				if (mpCompartment->gridBorders()->distanceFromBorder(pt.coords(), Borders::Y, Borders::LOW) < 0.5
 						&& (p_tcelltrans > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next()))/*Rule 32*/
@@ -203,7 +203,7 @@ void TcellGroup::act(const repast::Point<int> & pt)
 				}
 				if (p_tregcyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
-					mpCompartment->cytokineValue("eIL10", pt) += 5;
+					mpCompartment->secrete("eIL10", pt, 5);
 				}
 				if (mpCompartment->gridBorders()->distanceFromBorder(pt.coords(), Borders::Y, Borders::LOW) < 0.5
 						&& (p_tcelltrans > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next()))/*Rule 32*/
@@ -224,7 +224,7 @@ void TcellGroup::act(const repast::Point<int> & pt)
 			{
 				if (p_th1cyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
-					mpCompartment->cytokineValue("eIFNg", pt) += 5;
+					mpCompartment->secrete("eIFNg", pt, 5);
 				}
 				if (mpCompartment->gridBorders()->distanceFromBorder(pt.coords(), Borders::Y, Borders::LOW) < 0.5
 						&& (p_tcelltrans > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next()))/*Rule 32*/
@@ -276,7 +276,7 @@ void TcellGroup::act(const repast::Point<int> & pt)
 				}
 				if (p_tregcyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
-					mpCompartment->cytokineValue("eIL10", pt) += 5;
+					mpCompartment->secrete("eIL10", pt, 5);
 				}
 				if (p_tregdeath > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
@@ -302,7 +302,7 @@ void TcellGroup::act(const repast::Point<int> & pt)
 				}
 				if (p_th17cyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
-					mpCompartment->cytokineValue("eIL17", pt) += 5;
+					mpCompartment->secrete("eIL17", pt, 5);
 				}
 				if (p_th17death > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
@@ -322,7 +322,7 @@ void TcellGroup::act(const repast::Point<int> & pt)
 				}
 				if (p_th1cyto > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
-					mpCompartment->cytokineValue("eIFNg", pt) += 5;
+					mpCompartment->secrete("eIFNg", pt, 5);
 				}
 				if (p_th1death > repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0).next())
 				{
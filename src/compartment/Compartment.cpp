@@ -7,6 +7,7 @@
 #include "agent/SharedValueLayer.h"
 #include "agent/GroupInterface.h"
 #include "diffuser/DiffuserImpl.h"
+#include "diffuser/HaloExchange.h"
 #include "DataWriter/LocalFile.h"
 #include "grid/SharedSpace.h"
 
@@ -42,12 +43,19 @@ Compartment::Compartment(const Type & type):
   mpLayer(NULL),
   mpSpaceBorders(NULL),
   mpGridBorders(NULL),
+  mDiffuserCoarsening(1),
+  mDiffuserRefinement(1),
+  mDiffuserDimensions(),
+  mLocalDiffuserDimensions(),
+  mpDiffuserBorders(NULL),
   mAdjacentCompartments(2, std::vector< Type >(2, INVALID)),
   mUniform(repast::Random::instance()->createUniDoubleGenerator(0.0, 1.0)),
   mCytokineMap(),
   mpDiffuserValues(NULL),
   mGroups(),
   mpDiffuser(NULL),
+  mpHaloExchange(NULL),
+  mNeighborValues(),
   mNoLocalAgents(false)
 {
   std::string Name = Names[mType];
@@ -55,13 +63,21 @@ Compartment::Compartment(const Type & type):
 
   pProperties->getValue(Name + ".space.x", mProperties.spaceX);
   pProperties->getValue(Name + ".space.y", mProperties.spaceY);
+  pProperties->getValue(Name + ".space.z", mProperties.spaceZ);
   Properties::instance(Properties::run)->getValue("grid.size", mProperties.gridSize);
 
+  if (!Properties::instance(Properties::run)->getValue("diffuser.grid.size", mProperties.diffuserGridSize) ||
+      mProperties.diffuserGridSize <= 0.0)
+    {
+      mProperties.diffuserGridSize = mProperties.gridSize;
+    }
+
   determineProcessDimensions();
   mNoLocalAgents = repast::RepastProcess::instance()->rank() >= mProcessDimensions[0] * mProcessDimensions[1];
 
   mProperties.gridX = round(mProperties.spaceX / mProcessDimensions[Borders::X]) * mProcessDimensions[Borders::X];
   mProperties.gridY = round(mProperties.spaceY / mProcessDimensions[Borders::Y]) * mProcessDimensions[Borders::Y];
+  mProperties.gridZ = std::max(1.0, round(mProperties.spaceZ));
 
   std::string borderLow = pProperties->getValue(Name + ".border.y.low");
   mProperties.borderLowCompartment = pProperties->toEnum(borderLow, Names, INVALID);
@@ -97,6 +113,11 @@ Compartment::Compartment(const Type & type):
 
   LocalFile::debug() << getName() << ": Process Dimensions:     " << mProcessDimensions[0] << ", " << mProcessDimensions[1] << std::endl;
 
+  if (gridDepth() > 1)
+    {
+      LocalFile::debug() << getName() << ": Cytokine Depth:         " << gridDepth() << std::endl;
+    }
+
   mpLayer = new SharedLayer(Name, mProcessDimensions, mSpaceDimensions, mGridDimensions);
 
   LocalFile::debug() << " Space Dimensions:       " << mSpaceDimensions << std::endl;
@@ -106,6 +127,8 @@ Compartment::Compartment(const Type & type):
 
   mpLayer->addCompartment(this);
 
+  determineDiffuserGrid();
+
   /*
   repast::CartTopology topology(mProcessDimensions,
                                 mDimensions.origin().coords(),
@@ -120,6 +143,8 @@ Compartment::Compartment(const Type & type):
 
 void Compartment::determineProcessDimensions()
 {
+  // The agents are distributed by repast HPC, which supports only 2D process dimensions. Cytokine slabs
+  // (space.z) are therefore kept local, i.e., the depth is not distributed.
   std::vector< double > Dimension = repast::Point< double >(mProperties.spaceX, mProperties.spaceY).coords();
 
   int worldSize = repast::RepastProcess::instance()->worldSize();
@@ -131,25 +156,6 @@ void Compartment::determineProcessDimensions()
   size_t i = Borders::X;
   bool swap2D = false;
 
-  // TODO 3D process dimensions are not supported in repast HPC at this point in time
-  if (Dimension.size() > 2)
-    {
-      // TODO Pick the smallest dimension and swap see 2D
-      n = (int) pow(worldSize * Dimension[i] * Dimension[i] / (Dimension[i + 1] * Dimension[i + 2]), 1.0/3.0);
-
-      nMax = n;
-      while (worldSize % nMax > worldSize % (nMax + 1)) nMax++;
-
-      nMin = n;
-      while (worldSize % nMin > worldSize % (nMin - 1)) nMin--;
-
-      n = (n - nMin < nMax -n) ? nMin : nMax;
-
-      mProcessDimensions[i] = n;
-      worldSize /= n;
-      i++;
-    }
-
   if (Dimension.size() > 1)
     {
       if (Dimension[i + 1] < Dimension[i])
@@ -190,6 +196,74 @@ void Compartment::determineProcessDimensions()
     }
 }
 
+void Compartment::determineDiffuserGrid()
+{
+  // The ratio of the cell sizes must be integral and the local grids must consist of whole cytokine cells.
+  double Ratio = (mProperties.gridSize > 0.0) ? mProperties.diffuserGridSize / mProperties.gridSize : 1.0;
+  int Coarsening = std::max(1L, lround(Ratio));
+  int Refinement = std::max(1L, lround(1.0 / Ratio));
+
+  const repast::GridDimensions & Local = mpLayer->localGridDimensions();
+  int LocalX = round(Local.extents(Borders::X));
+  int LocalY = round(Local.extents(Borders::Y));
+
+  if (Ratio >= 1.0)
+    {
+      Refinement = 1;
+
+      if (fabs(Ratio - Coarsening) > 1e-6 * Ratio ||
+          LocalX % Coarsening != 0 ||
+          LocalY % Coarsening != 0)
+        {
+          LocalFile::debug() << getName() << ": diffuser grid size " << mProperties.diffuserGridSize
+                             << " does not divide the local grid, using grid size." << std::endl;
+          Coarsening = 1;
+        }
+    }
+  else
+    {
+      Coarsening = 1;
+
+      if (fabs(1.0 / Ratio - Refinement) > 1e-6 / Ratio)
+        {
+          LocalFile::debug() << getName() << ": diffuser grid size " << mProperties.diffuserGridSize
+                             << " does not divide the grid size, using grid size." << std::endl;
+          Refinement = 1;
+        }
+    }
+
+  mDiffuserCoarsening = Coarsening;
+  mDiffuserRefinement = Refinement;
+
+  std::vector< double > Origin(2);
+  std::vector< double > Extents(2);
+
+  for (int i = 0; i < 2; ++i)
+    {
+      Origin[i] = mGridDimensions.origin(i) * Refinement / Coarsening;
+      Extents[i] = mGridDimensions.extents(i) * Refinement / Coarsening;
+    }
+
+  mDiffuserDimensions = repast::GridDimensions(Origin, Extents);
+
+  for (int i = 0; i < 2; ++i)
+    {
+      Origin[i] = Local.origin(i) * Refinement / Coarsening;
+      Extents[i] = Local.extents(i) * Refinement / Coarsening;
+    }
+
+  mLocalDiffuserDimensions = repast::GridDimensions(Origin, Extents);
+
+  mpDiffuserBorders = new Borders(mDiffuserDimensions);
+  mpDiffuserBorders->setBorderType(Borders::Y, Borders::LOW, mProperties.borderLowType);
+  mpDiffuserBorders->setBorderType(Borders::Y, Borders::HIGH, mProperties.borderHighType);
+
+  if (Coarsening != 1 || Refinement != 1)
+    {
+      LocalFile::debug() << getName() << ": Diffuser Grid Dimensions:       " << mDiffuserDimensions << std::endl;
+      LocalFile::debug() << getName() << ": Local Diffuser Grid Dimensions: " << mLocalDiffuserDimensions << std::endl;
+    }
+}
 
 // virtual
 Compartment::~Compartment()
@@ -202,6 +276,8 @@ Compartment::~Compartment()
 //  if (mpLayer != NULL) delete mpLayer;
   if (mpSpaceBorders != NULL) delete mpSpaceBorders;
   if (mpGridBorders != NULL) delete mpGridBorders;
+  if (mpDiffuserBorders != NULL) delete mpDiffuserBorders;
+  if (mpHaloExchange != NULL) delete mpHaloExchange;
 }
 
 const repast::GridDimensions & Compartment::spaceDimensions() const
@@ -224,6 +300,11 @@ const repast::GridDimensions & Compartment::localGridDimensions() const
   return mpLayer->localGridDimensions();
 }
 
+int Compartment::gridDepth() const
+{
+  return mProperties.gridZ;
+}
+
 const Borders * Compartment::spaceBorders() const
 {
   return mpSpaceBorders;
@@ -234,6 +315,43 @@ const Borders * Compartment::gridBorders() const
   return mpGridBorders;
 }
 
+const repast::GridDimensions & Compartment::diffuserDimensions() const
+{
+  return mDiffuserDimensions;
+}
+
+const repast::GridDimensions & Compartment::localDiffuserDimensions() const
+{
+  return mLocalDiffuserDimensions;
+}
+
+const Borders * Compartment::diffuserBorders() const
+{
+  return mpDiffuserBorders;
+}
+
+const int & Compartment::diffuserCoarsening() const
+{
+  return mDiffuserCoarsening;
+}
+
+const int & Compartment::diffuserRefinement() const
+{
+  return mDiffuserRefinement;
+}
+
+std::vector< int > Compartment::diffuserToGrid(const std::vector< int > & location) const
+{
+  std::vector< int > Grid(location);
+
+  for (size_t i = 0; i < 2 && i < Grid.size(); ++i)
+    {
+      Grid[i] = (int) floor(double(location[i]) * mDiffuserCoarsening / mDiffuserRefinement);
+    }
+
+  return Grid;
+}
+
 const Compartment * Compartment::getAdjacentCompartment(const Borders::Coodinate &coordinate, const Borders::Side & side) const
 {
   return instance(mAdjacentCompartments[coordinate][side]);
@@ -634,7 +752,7 @@ void Compartment::getAgents(const repast::Point< int > &pt, const int & xOffset,
 
 size_t Compartment::addCytokine(const std::string & name)
 {
-  Cytokine * pCytokine = new Cytokine(getName() + "." + name);
+  Cytokine * pCytokine = new Cytokine(getName() + "." + name, double(mDiffuserCoarsening) / mDiffuserRefinement);
 
   pCytokine->setIndex(mCytokines.size());
   mCytokines.push_back(pCytokine);
@@ -660,30 +778,111 @@ const std::vector< Cytokine * > & Compartment::getCytokines() const
   return mCytokines;
 }
 
-std::vector< double > & Compartment::cytokineValues(const repast::Point< int > & pt)
+double Compartment::cytokineValue(const size_t & index, const repast::Point< int > & pt)
 {
-  if (mpDiffuserValues != NULL &&
-      mpDiffuserValues->contains(pt))
+  if (mDiffuserCoarsening == 1 &&
+      mDiffuserRefinement == 1)
     {
-      // LocalFile::debug() << "  local" << std::endl;
+      return diffuserValue(index, pt);
+    }
+
+  std::vector< repast::Point< int > > Cells;
+  std::vector< double > Weights;
+  interpolation(pt, Cells, Weights);
 
-      return mpDiffuserValues->operator[](pt);
+  double Value = 0.0;
+
+  for (size_t i = 0; i < Cells.size(); ++i)
+    {
+      Value += Weights[i] * diffuserValue(index, Cells[i]);
     }
 
-  // We loop through all non local agents and check whether they contain the value
-  SharedLayer::Context::const_state_aware_iterator it = mpLayer->getValueContext().begin(SharedLayer::Context::NON_LOCAL);
-  SharedLayer::Context::const_state_aware_iterator end = mpLayer->getValueContext().end(SharedLayer::Context::NON_LOCAL);
+  return Value;
+}
 
-  std::vector< double > * pFound = NULL;
+void Compartment::interpolation(const repast::Point< int > & pt,
+                                std::vector< repast::Point< int > > & cells,
+                                std::vector< double > & weights) const
+{
+  cells.clear();
+  weights.clear();
 
-  for (; it != end && pFound == NULL; ++it)
+  if (mDiffuserRefinement > 1)
     {
-      SharedValueLayer * pValues = static_cast< SharedValueLayer * >(&**it);
-      // LocalFile::debug() << "  trying: " << pValues->origin() << ", " << pValues->shape() << std::endl;
+      // The agent cell is the average of the cytokine cells it covers.
+      const int & Refinement = mDiffuserRefinement;
+      const double Weight = 1.0 / (Refinement * Refinement);
+
+      for (int y = 0; y < Refinement; ++y)
+        for (int x = 0; x < Refinement; ++x)
+          {
+            cells.push_back(repast::Point< int >(pt[Borders::X] * Refinement + x, pt[Borders::Y] * Refinement + y));
+            weights.push_back(Weight);
+          }
+
+      return;
+    }
+
+  // Bilinear interpolation between the centers of the cytokine cells at the center of the agent cell.
+  // Cells beyond the borders are mapped to the mirrored or, for WRAP borders, the periodic cell.
+  const int & Coarsening = mDiffuserCoarsening;
+  std::vector< int > Low(2);
+  std::vector< double > Fraction(2);
 
-      pFound = pValues->tryLocation(pt);
+  for (int i = 0; i < 2; ++i)
+    {
+      double Center = (pt[i] + 0.5) / Coarsening - 0.5;
+      Low[i] = (int) floor(Center);
+      Fraction[i] = Center - Low[i];
     }
 
+  for (int y = 0; y < 2; ++y)
+    for (int x = 0; x < 2; ++x)
+      {
+        double Weight = (x ? Fraction[Borders::X] : 1.0 - Fraction[Borders::X]) *
+                        (y ? Fraction[Borders::Y] : 1.0 - Fraction[Borders::Y]);
+
+        if (Weight == 0.0) continue;
+
+        std::vector< int > Cell(2);
+        Cell[Borders::X] = Low[Borders::X] + x;
+        Cell[Borders::Y] = Low[Borders::Y] + y;
+
+        for (int i = 0; i < 2; ++i)
+          {
+            const int Origin = round(mDiffuserDimensions.origin(i));
+            const int Extent = round(mDiffuserDimensions.extents(i));
+            bool Wrap = mpDiffuserBorders->getBorderType((Borders::Coodinate) i, Borders::LOW) == Borders::WRAP;
+
+            if (Cell[i] < Origin)
+              {
+                Cell[i] = Wrap ? Cell[i] + Extent : 2 * Origin - 1 - Cell[i];
+              }
+            else if (Cell[i] >= Origin + Extent)
+              {
+                Cell[i] = Wrap ? Cell[i] - Extent : 2 * (Origin + Extent) - 1 - Cell[i];
+              }
+          }
+
+        cells.push_back(Cell);
+        weights.push_back(Weight);
+      }
+}
+
+double & Compartment::diffuserValue(const size_t & index, const repast::Point< int > & pt)
+{
+  if (mpDiffuserValues != NULL &&
+      mpDiffuserValues->contains(pt))
+    {
+      // LocalFile::debug() << "  local" << std::endl;
+
+      return mpDiffuserValues->operator()(index, pt);
+    }
+
+  // Cells beyond the ghost ring are found in the buffer values of their owner.
+  SharedValueLayer * pOwner = neighborValues(pt);
+  double * pFound = (pOwner != NULL) ? pOwner->tryLocation(index, pt) : NULL;
+
   if (pFound != NULL)
     {
       return *pFound;
@@ -696,11 +895,11 @@ std::vector< double > & Compartment::cytokineValues(const repast::Point< int > &
   }
   throw std::runtime_error("cytokine value not found: location not shared");
 
-  static std::vector< double > NaN(mCytokines.size(), std::numeric_limits< double >::quiet_NaN());
+  static double NaN = std::numeric_limits< double >::quiet_NaN();
   return NaN;
 }
 
-double & Compartment::cytokineValue(const std::string & name, const repast::Point< int > & pt)
+double Compartment::cytokineValue(const std::string & name, const repast::Point< int > & pt)
 {
   std::vector< int > Location = pt.coords();
   // LocalFile::debug() << name << "(" << getName() << "): (" << Location[Borders::X] << ", " << Location[Borders::Y] << ") -> ";
@@ -711,7 +910,7 @@ double & Compartment::cytokineValue(const std::string & name, const repast::Poin
     {
       // LocalFile::debug() << "(" << Location[Borders::X] << ", " << Location[Borders::Y] << ")" << std::endl;
 
-      return cytokineValues(Location)[mCytokineMap[name]];
+      return cytokineValue(mCytokineMap[name], Location);
     }
   else if (pTarget != NULL)
     {
@@ -727,7 +926,7 @@ double & Compartment::cytokineValue(const std::string & name, const repast::Poin
   return NaN;
 }
 
-double & Compartment::cytokineValue(const std::string & name, const repast::Point< int > & pt, const int & xOffset, const int & yOffset)
+double Compartment::cytokineValue(const std::string & name, const repast::Point< int > & pt, const int & xOffset, const int & yOffset)
 {
   std::vector< int > Location = pt.coords();
   // LocalFile::debug() << name << "(" << getName() << "): (" << Location[Borders::X] << ", " << Location[Borders::Y] << ") + (" << xOffset << ", " << yOffset << ")" << std::endl;
@@ -738,6 +937,117 @@ double & Compartment::cytokineValue(const std::string & name, const repast::Poin
   return cytokineValue(name, Location);
 }
 
+void Compartment::secrete(const std::string & name, const repast::Point< int > & pt, const double & amount)
+{
+  std::vector< int > Location = pt.coords();
+
+  Compartment * pTarget = transform(Location);
+
+  if (pTarget == this)
+    {
+      std::map< std::string, size_t >::const_iterator found = mCytokineMap.find(name);
+
+      if (found == mCytokineMap.end())
+        {
+          throw std::runtime_error("cytokine secretion: unknown cytokine " + name);
+        }
+
+      secrete(found->second, Location, amount);
+      return;
+    }
+  else if (pTarget != NULL)
+    {
+      pTarget->secrete(name, Location, amount);
+      return;
+    }
+
+  throw std::runtime_error("cytokine secretion: unable to determine target compartment");
+}
+
+void Compartment::secrete(const std::string & name, const repast::Point< int > & pt, const int & xOffset, const int & yOffset, const double & amount)
+{
+  std::vector< int > Location = pt.coords();
+
+  Location[Borders::X] += xOffset;
+  Location[Borders::Y] += yOffset;
+
+  secrete(name, Location, amount);
+}
+
+void Compartment::secrete(const size_t & index, const repast::Point< int > & pt, const double & amount)
+{
+  if (mpDiffuserValues == NULL)
+    {
+      throw std::runtime_error("cytokine secretion: no local values defined");
+    }
+
+  if (mDiffuserCoarsening == 1 &&
+      mDiffuserRefinement == 1)
+    {
+      // The location must be shared, i.e., diffuserValue throws otherwise.
+      diffuserValue(index, pt);
+      mpDiffuserValues->secrete(index, pt, amount);
+
+      return;
+    }
+
+  std::vector< repast::Point< int > > Cells;
+  std::vector< double > Weights;
+  interpolation(pt, Cells, Weights);
+
+  // The amount is scaled by the ratio of the cell areas, i.e., the sum over the covered area is conserved.
+  const double Scale = double(mDiffuserRefinement * mDiffuserRefinement) / (mDiffuserCoarsening * mDiffuserCoarsening);
+
+  for (size_t i = 0; i < Cells.size(); ++i)
+    {
+      diffuserValue(index, Cells[i]);
+      mpDiffuserValues->secrete(index, Cells[i], Scale * Weights[i] * amount);
+    }
+}
+
+void Compartment::applySecretions(SharedValueLayer & secreted)
+{
+  SharedValueLayer::Secretions::const_iterator it = secreted.getSecretions().begin();
+  SharedValueLayer::Secretions::const_iterator end = secreted.getSecretions().end();
+
+  for (; it != end; ++it)
+    {
+      repast::Point< int > Location(it->first);
+
+      // Owned cells are updated locally, for any other cell the neighbor's copy is updated,
+      // which provides the ghost cells.
+      if (mpDiffuserValues->owns(Location))
+        {
+          for (size_t k = 0; k < it->second.size(); ++k)
+            {
+              (*mpDiffuserValues)(k, Location) += it->second[k];
+            }
+
+          continue;
+        }
+
+      SharedValueLayer * pFound = neighborValues(Location);
+
+      if (pFound != NULL &&
+          !pFound->buffers(Location))
+        {
+          pFound = NULL;
+        }
+
+      // Cells which are not shared with this process are updated by their owner.
+      if (pFound == NULL) continue;
+
+      for (size_t k = 0; k < it->second.size(); ++k)
+        {
+          double * pValue = pFound->tryLocation(k, Location);
+
+          if (pValue != NULL) *pValue += it->second[k];
+        }
+    }
+
+  secreted.clearSecretions();
+}
+
 void Compartment::initializeDiffuserData()
 {
   if (mNoLocalAgents) return;
@@ -749,26 +1059,113 @@ void Compartment::initializeDiffuserData()
       mpDiffuserValues = new SharedValueLayer(Agent::DiffuserValues, mType, mCytokineMap.size());
       mpLayer->addDiffuserValues(mpDiffuserValues, this);
 
-      std::vector< double > InitialValues(mCytokineMap.size());
-      std::vector< double >::iterator itInitialValue = InitialValues.begin();
       std::vector< Cytokine * >::const_iterator it = mCytokines.begin();
       std::vector< Cytokine * >::const_iterator end = mCytokines.end();
 
-      for (; it != end; ++it, ++itInitialValue)
+      // The ghost ring is overwritten by the synchronization below.
+      for (size_t k = 0; it != end; ++it, ++k)
         {
-          *itInitialValue = (*it)->getInitialValue();
+          mpDiffuserValues->getLocalValues()->fill(k, (*it)->getInitialValue());
         }
+    }
+
+  if (mpDiffuser == NULL)
+    {
+      mpDiffuser = new DiffuserImpl(this);
+    }
+
+  // The diffuser requires that the ghost ring holds the boundary values.
+  synchronizeDiffuser();
+
+  // The Repast synchronization above created the copies of the neighbors' values. Creating the exchange
+  // is collective over all processes, i.e., either all or no processes must return early above. This holds
+  // as the process dimensions cover all processes (mNoLocalAgents is false) and all processes have the same
+  // cytokines.
+  if (mpHaloExchange == NULL &&
+      HaloExchange::method() == HaloExchange::DIRECT)
+    {
+      createHaloExchange();
+    }
+}
+
+void Compartment::createHaloExchange()
+{
+  int Rank = repast::RepastProcess::instance()->rank();
+
+  // The targets are the processes to which Repast pushes our values.
+  std::set< repast::AgentId > AgentsToTest;
+  std::map< int, std::set< repast::AgentId > > AgentsToPush;
+  getBorderValuesToPush(AgentsToTest, AgentsToPush);
 
-      for (Iterator itGrid = begin(); itGrid; itGrid.next())
+  std::vector< int > Targets;
+  std::map< int, std::set< repast::AgentId > >::const_iterator itPush = AgentsToPush.begin();
+  std::map< int, std::set< repast::AgentId > >::const_iterator endPush = AgentsToPush.end();
+
+  for (; itPush != endPush; ++itPush)
+    {
+      if (itPush->first != Rank)
         {
-          mpDiffuserValues->operator[](*itGrid) = InitialValues;
+          Targets.push_back(itPush->first);
         }
     }
 
-  if (mpDiffuser == NULL)
+  std::vector< SharedValueLayer * > Sources;
+  std::vector< int > SourceRanks;
+  SharedLayer::Context::const_state_aware_iterator it = mpLayer->getValueContext().begin(SharedLayer::Context::NON_LOCAL);
+  SharedLayer::Context::const_state_aware_iterator end = mpLayer->getValueContext().end(SharedLayer::Context::NON_LOCAL);
+
+  for (; it != end; ++it)
     {
-      mpDiffuser = new DiffuserImpl(this);
+      Sources.push_back(static_cast< SharedValueLayer * >(&**it));
+      SourceRanks.push_back((*it)->getId().currentRank());
     }
+
+  // Each compartment uses its own pair of tags above the ones used by Repast.
+  mpHaloExchange = new HaloExchange(*repast::RepastProcess::instance()->getCommunicator(), 7000 + 2 * mType,
+                                    mpDiffuserValues, Targets, Sources, SourceRanks, *mpDiffuserBorders);
+
+  LocalFile::debug() << getName() << ": diffuser exchange: " << HaloExchange::MethodNames[HaloExchange::DIRECT]
+                     << ", targets: " << Targets.size() << ", sources: " << Sources.size() << std::endl;
+}
+
+void Compartment::indexNeighborValues()
+{
+  mNeighborValues.assign(mProcessDimensions[Borders::X] * mProcessDimensions[Borders::Y], NULL);
+
+  const int OriginX = round(mDiffuserDimensions.origin(Borders::X));
+  const int OriginY = round(mDiffuserDimensions.origin(Borders::Y));
+  const int Width = round(mLocalDiffuserDimensions.extents(Borders::X));
+  const int Height = round(mLocalDiffuserDimensions.extents(Borders::Y));
+
+  SharedLayer::Context::const_state_aware_iterator it = mpLayer->getValueContext().begin(SharedLayer::Context::NON_LOCAL);
+  SharedLayer::Context::const_state_aware_iterator end = mpLayer->getValueContext().end(SharedLayer::Context::NON_LOCAL);
+
+  for (; it != end; ++it)
+    {
+      SharedValueLayer * pNeighbor = static_cast< SharedValueLayer * >(&**it);
+      const repast::Point< int > & Origin = pNeighbor->origin();
+
+      mNeighborValues[((Origin[Borders::Y] - OriginY) / Height) * mProcessDimensions[Borders::X]
+                      + (Origin[Borders::X] - OriginX) / Width] = pNeighbor;
+    }
+}
+
+SharedValueLayer * Compartment::neighborValues(const repast::Point< int > & pt) const
+{
+  // All local grids have the same shape, i.e., the owner follows from the location.
+  const int Width = round(mLocalDiffuserDimensions.extents(Borders::X));
+  const int Height = round(mLocalDiffuserDimensions.extents(Borders::Y));
+  const int x = pt[Borders::X] - round(mDiffuserDimensions.origin(Borders::X));
+  const int y = pt[Borders::Y] - round(mDiffuserDimensions.origin(Borders::Y));
+
+  if (x < 0 || x >= Width * mProcessDimensions[Borders::X] ||
+      y < 0 || y >= Height * mProcessDimensions[Borders::Y] ||
+      mNeighborValues.empty())
+    {
+      return NULL;
+    }
+
+  return mNeighborValues[(y / Height) * mProcessDimensions[Borders::X] + x / Width];
 }
 
 SharedValueLayer * Compartment::getDiffuserData()
@@ -1101,7 +1498,13 @@ void Compartment::getBorderValuesToPush(const Borders::Coodinate & coordinate,
   // LocalFile::debug() << std::endl;
 }
 
-void Compartment::synchronizeDiffuser()
+void Compartment::synchronizeDiffuser(const bool & secretions)
+{
+  startSynchronizeDiffuser(secretions);
+  finishSynchronizeDiffuser();
+}
+
+void Compartment::startSynchronizeDiffuser(const bool & secretions)
 {
   if (mNoLocalAgents) return;
 
@@ -1110,22 +1513,64 @@ void Compartment::synchronizeDiffuser()
 
   // mpDiffuserValues->write(LocalFile::debug(), "\t", this);
 
-  mpLayer->synchronizeDiffuser();
+  // The Repast synchronization is blocking and done when finishing.
+  if (mpHaloExchange != NULL)
+    {
+      mpHaloExchange->start(secretions);
+    }
+}
+
+double Compartment::finishSynchronizeDiffuser()
+{
+  if (mNoLocalAgents) return 0.0;
+
+  // Nothing to do
+  if (mpDiffuserValues == NULL) return 0.0;
+
+  double Start = MPI_Wtime();
+
+  if (mpHaloExchange != NULL)
+    {
+      mpHaloExchange->finish();
+    }
+  else
+    {
+      mpLayer->synchronizeDiffuser();
+    }
+
+  double Wait = MPI_Wtime() - Start;
+
+  // Repast may create copies of the neighbors' values during the synchronization.
+  if (mpHaloExchange == NULL)
+    {
+      indexNeighborValues();
+    }
 
-  // We loop through all non local agents and update the local diffuser border values.
   SharedLayer::Context::const_state_aware_iterator it = mpLayer->getValueContext().begin(SharedLayer::Context::NON_LOCAL);
   SharedLayer::Context::const_state_aware_iterator end = mpLayer->getValueContext().end(SharedLayer::Context::NON_LOCAL);
 
+  // The secretions of all processes sharing a cell are added to the owned value and to the neighbors'
+  // copies before the ghost ring is updated, i.e., all processes apply the same sources.
+  applySecretions(*mpDiffuserValues);
+
   for (; it != end; ++it)
+    {
+      applySecretions(*static_cast< SharedValueLayer * >(&**it));
+    }
+
+  // We loop through all non local agents and update the local diffuser border values.
+  for (it = mpLayer->getValueContext().begin(SharedLayer::Context::NON_LOCAL); it != end; ++it)
     {
       mpDiffuserValues->updateBufferValues(*static_cast< SharedValueLayer * >(&**it),
-                                           *mpGridBorders);
+                                           *mpDiffuserBorders);
     }
 
   // Complete Information based on border settings
-  mpDiffuserValues->completeBufferValues(*mpGridBorders);
+  mpDiffuserValues->completeBufferValues(*mpDiffuserBorders);
 
   // mpDiffuserValues->write(LocalFile::debug(), "\t", this);
+
+  return Wait;
 }
 
 const Compartment::Type & Compartment::getType() const
@@ -1269,8 +1714,10 @@ void Compartment::diffuse()
 {
   if (mpDiffuser != NULL)
     {
-      mpDiffuser->diffuse(1.0); // TODO CRITICAL determine step size;
+      // The secretions of the agents are added as sources before the integration.
+      // The diffuser synchronizes the ghost ring after its last step.
       synchronizeDiffuser();
+      mpDiffuser->diffuse(1.0); // TODO CRITICAL determine step size;
     }
 }
 
@@ -12,6 +12,7 @@ class Cytokine;
 class SharedValueLayer;
 class GroupInterface;
 class DiffuserImpl;
+class HaloExchange;
 
 template <class T, class Package, class PackageExchange> class ICompartmentLayer;
 
@@ -32,9 +33,12 @@ public:
   {
     double spaceX;
     double spaceY;
+    double spaceZ;
     double gridSize;
+    double diffuserGridSize;
     double gridX;
     double gridY;
+    double gridZ;
     Type borderLowCompartment;
     Borders::Type borderLowType;
     Type borderHighCompartment;
@@ -52,8 +56,31 @@ public:
   const repast::GridDimensions & gridDimensions() const;
   const repast::GridDimensions & localSpaceDimensions() const;
   const repast::GridDimensions & localGridDimensions() const;
+
+  /**
+   * The cytokines may diffuse in a slab of the given depth, which is not distributed over the processes.
+   * The agents are located in the layer z = 0. A depth of 1 indicates a 2D compartment.
+   * @return const int & gridDepth
+   */
+  int gridDepth() const;
   const Borders * spaceBorders() const;
   const Borders * gridBorders() const;
+
+  /**
+   * The cytokines are discretized on their own grid with the cell size diffuser.grid.size (run.props),
+   * where each cytokine cell covers coarsening x coarsening agent cells or each agent cell covers
+   * refinement x refinement cytokine cells. The diffuser grid has the same borders as the agent grid.
+   */
+  const repast::GridDimensions & diffuserDimensions() const;
+  const repast::GridDimensions & localDiffuserDimensions() const;
+  const Borders * diffuserBorders() const;
+  const int & diffuserCoarsening() const;
+  const int & diffuserRefinement() const;
+
+  /**
+   * The agent cell containing the lower corner of the cytokine cell
+   */
+  std::vector< int > diffuserToGrid(const std::vector< int > & location) const;
   const Compartment * getAdjacentCompartment(const Borders::Coodinate &coordinate, const Borders::Side & side) const;
   Iterator begin();
 
@@ -83,15 +110,43 @@ public:
   const std::vector< Cytokine * > & getCytokines() const;
   const Cytokine * getCytokine(const std::string & name) const;
 
-  double & cytokineValue(const std::string & name, const repast::Point< int > & pt);
-  double & cytokineValue(const std::string & name, const repast::Point< int > & pt, const int & xOffset, const int & yOffset);
-  std::vector< double > & cytokineValues(const repast::Point< int > & pt);
+  /**
+   * The cytokine value of the agent cell, which is interpolated bilinearly from a coarser cytokine grid
+   * and restricted by averaging from a finer one.
+   */
+  double cytokineValue(const std::string & name, const repast::Point< int > & pt);
+  double cytokineValue(const std::string & name, const repast::Point< int > & pt, const int & xOffset, const int & yOffset);
+  double cytokineValue(const size_t & index, const repast::Point< int > & pt);
+
+  /**
+   * Secrete the amount of the cytokine at the location. The secretions are added to the values before
+   * the next diffusion, where secretions into ghost cells are added on the process owning the cell.
+   * On a coarser or finer cytokine grid the amount is deposited with the transposed weights of
+   * cytokineValue, i.e., the secreted amount is conserved.
+   */
+  void secrete(const std::string & name, const repast::Point< int > & pt, const double & amount);
+  void secrete(const std::string & name, const repast::Point< int > & pt, const int & xOffset, const int & yOffset, const double & amount);
+  void secrete(const size_t & index, const repast::Point< int > & pt, const double & amount);
 
   void initializeDiffuserData();
   SharedValueLayer * getDiffuserData();
 
   void synchronizeCells();
-  void synchronizeDiffuser();
+
+  /**
+   * Synchronize the diffuser values and apply the secretions. Only the synchronization at the start of
+   * the tick needs to exchange secretions, the steps of the diffuser pass false, which must be agreed
+   * on by all processes.
+   */
+  void synchronizeDiffuser(const bool & secretions = true);
+
+  /**
+   * The synchronization of the diffuser split to overlap the exchange with computations which neither
+   * modify the local diffuser values nor read their ghost ring. Finishing returns the time in seconds
+   * spent waiting for the neighbors.
+   */
+  void startSynchronizeDiffuser(const bool & secretions = true);
+  double finishSynchronizeDiffuser();
 
   const Type & getType() const;
 
@@ -126,6 +181,32 @@ public:
 
 private:
   void determineProcessDimensions();
+  void determineDiffuserGrid();
+  void createHaloExchange();
+  void applySecretions(SharedValueLayer & secreted);
+
+  /**
+   * The value of the cytokine cell (diffuser grid coordinates) which must be owned or shared.
+   */
+  double & diffuserValue(const size_t & index, const repast::Point< int > & pt);
+
+  /**
+   * Index the copies of the neighbors' diffuser values by the position of their local grid in the
+   * process grid, i.e., the owner of a cell beyond the ghost ring is found without searching.
+   */
+  void indexNeighborValues();
+
+  /**
+   * The copy of the diffuser values of the neighbor owning the cell (diffuser grid coordinates) or NULL.
+   */
+  SharedValueLayer * neighborValues(const repast::Point< int > & pt) const;
+
+  /**
+   * The cytokine cells and their weights for the agent cell.
+   */
+  void interpolation(const repast::Point< int > & pt,
+                     std::vector< repast::Point< int > > & cells,
+                     std::vector< double > & weights) const;
   void getBorderCellsToPush(const Borders::Coodinate &coordinate,
                             const Borders::Side & side,
                              std::map< int, std::set< repast::AgentId > > & agentsToPush);
@@ -149,6 +230,12 @@ private:
   Borders * mpSpaceBorders;
   Borders * mpGridBorders;
 
+  int mDiffuserCoarsening;
+  int mDiffuserRefinement;
+  repast::GridDimensions mDiffuserDimensions;
+  repast::GridDimensions mLocalDiffuserDimensions;
+  Borders * mpDiffuserBorders;
+
   std::vector< std::vector< Type > > mAdjacentCompartments;
   repast::DoubleUniformGenerator mUniform;
 
@@ -158,6 +245,8 @@ private:
   SharedValueLayer * mpDiffuserValues;
   std::vector< GroupInterface * > mGroups;
   DiffuserImpl * mpDiffuser;
+  HaloExchange * mpHaloExchange;
+  std::vector< SharedValueLayer * > mNeighborValues;
 
   bool mNoLocalAgents;
 
@@ -1,7 +1,21 @@
 #include "DiffuserImpl.h"
+#include "diffuser/Multigrid.h"
 #include "compartment/Compartment.h"
 #include "agent/Cytokine.h"
 #include "DataWriter/LocalFile.h"
+#include "grid/Properties.h"
+
+#include "repast_hpc/RepastProcess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 
 using namespace ENISI;
 
@@ -10,312 +24,1038 @@ using namespace ENISI;
 const double DiffuserImpl::DEFAULT_MAX = 0x7FFF;
 const double DiffuserImpl::DEFAULT_MIN = -DiffuserImpl::DEFAULT_MAX;
 
+// static
+const char* DiffuserImpl::SolverNames[] = {"explicit", "ADI", "RKL", NULL};
+
 /* static private variables */
 
 DiffuserImpl::~DiffuserImpl()
-{}
+{
+  if (mpSweep != NULL) delete mpSweep;
+  if (mpPreviousValues != NULL) delete mpPreviousValues;
+  if (mpSteadyValues != NULL) delete mpSteadyValues;
+
+  std::vector< Multigrid * >::iterator it = mSteadySolvers.begin();
+  std::vector< Multigrid * >::iterator end = mSteadySolvers.end();
+
+  for (; it != end; ++it)
+    if (*it != NULL) delete *it;
+
+  deleteLineSolvers();
+  TridiagonalSolver::freeCommunicator(mRowCommunicator);
+  TridiagonalSolver::freeCommunicator(mColumnCommunicator);
+}
 
 DiffuserImpl::DiffuserImpl(Compartment * pCompartment) :
   mpCompartment(pCompartment),
   mCytokines(pCompartment->getCytokines()),
   mDeltaT(1.0),
   mShape(std::vector< int >(mpCompartment->spaceDimensions().dimensionCount(), 2)),
-  mpNewValues(NULL),
-  mpCurrentValues(NULL),
-  mpDiffuserData(mpCompartment->getDiffuserData())
+  mpDiffuserData(mpCompartment->getDiffuserData()),
+  mKernel(StencilKernel::Scalar),
+  mStencil3D(StencilKernel::Point27),
+  mThreads(1),
+  mpSweep(NULL),
+  mFuseSteps(false),
+  mOverlap(false),
+  mEpsilon(0.0),
+  mSolver(EXPLICIT),
+  mRowCommunicator(MPI_COMM_NULL),
+  mColumnCommunicator(MPI_COMM_NULL),
+  mLineSolverDeltaT(0.0),
+  mRowSolvers(),
+  mColumnSolvers(),
+  mRightHandSide(),
+  mSpectralRadius(0.0),
+  mStages(0),
+  mpPreviousValues(NULL),
+  mPlanes(),
+  mStableDeltaT(),
+  mDiffusing(),
+  mDecaying(),
+  mSteadySolvers(),
+  mpSteadyValues(NULL),
+  mSteadyCycles(20),
+  mSteadyTolerance(1e-6),
+  mTick(0)
 {
   mShape = mpDiffuserData->getLocalValues()->shape();
 
-  mpCurrentValues = mpDiffuserData->getLocalValues();
-  mpNewValues = new DenseMatrix< std::vector< double > >(mShape, std::vector< double >(pCompartment->getCytokines().size(), 0.0));
+  mSolver = Properties::toEnum(Properties::instance(Properties::model)->getValue(mpCompartment->getName() + ".diffuser.solver"), SolverNames, EXPLICIT);
+
+  if (mSolver == ADI && mShape.dimensionCount() != 2)
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": ADI diffuser requires 2D, using explicit." << std::endl;
+      mSolver = EXPLICIT;
+    }
+
+  LocalFile::debug() << mpCompartment->getName() << ": diffuser solver: " << SolverNames[mSolver] << std::endl;
+
+  const Properties * pRun = Properties::instance(Properties::run);
+  mKernel = StencilKernel::select(Properties::toEnum(pRun->getValue("diffuser.kernel"), StencilKernel::TypeNames, StencilKernel::Auto));
+
+  LocalFile::debug() << mpCompartment->getName() << ": diffuser kernel: " << StencilKernel::TypeNames[mKernel] << std::endl;
+
+  if (mShape.dimensionCount() == 3)
+    {
+      mStencil3D = Properties::toEnum(Properties::instance(Properties::model)->getValue(mpCompartment->getName() + ".diffuser.stencil"),
+                                      StencilKernel::Stencil3DNames, StencilKernel::Point27);
+
+      LocalFile::debug() << mpCompartment->getName() << ": diffuser stencil: " << StencilKernel::Stencil3DNames[mStencil3D] << " point" << std::endl;
+    }
+
+  // The rows of the local field are partitioned among the threads. Each cell is computed
+  // by exactly the same operations, i.e., the results do not depend on the thread count.
+  if (!pRun->getValue("diffuser.threads", mThreads) ||
+      mThreads < 1)
+    {
+      mThreads = 1;
+    }
+
+#ifndef _OPENMP
+  if (mThreads > 1)
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": diffuser threads require OpenMP, using 1." << std::endl;
+      mThreads = 1;
+    }
+#endif
+
+  LocalFile::debug() << mpCompartment->getName() << ": diffuser threads: " << mThreads << std::endl;
 
   // Calculate the maximal time step (mDeltaT)
   std::vector< Cytokine * >::const_iterator it = mCytokines.begin();
   std::vector< Cytokine * >::const_iterator end = mCytokines.end();
 
-  for (; it != end; ++it)
+  // The stencils are positive (monotone) for steps up to 1 / (degradation + center weight * diffusion),
+  // where the center weight is the sum of the neighbor weights of the stencil (1D: 2, 2D: 6).
+  const double CenterWeight = StencilKernel::centerWeight(mShape.dimensionCount(), mStencil3D);
+  double RadiusWeight = (mShape.dimensionCount() == 1) ? 4.0 : 9.6;
+
+  if (mShape.dimensionCount() == 3)
     {
-      double tmp = 1.0/((*it)->getDegradation() + 2.0 * (*it)->getDiffusion() * mShape.dimensionCount());
+      RadiusWeight = (mStencil3D == StencilKernel::Point27) ? 9.6 : 21.6;
+    }
+
+  for (size_t k = 0; it != end; ++it, ++k)
+    {
+      double tmp = 1.0/((*it)->getDegradation() + CenterWeight * (*it)->getDiffusion());
+
+      mStableDeltaT.push_back(std::min(1.0, tmp));
+
+      // Fields without diffusion are not integrated by the solvers. They decay exactly and
+      // fields which neither diffuse nor degrade are not touched.
+      if ((*it)->getDiffusion() == 0.0)
+        {
+          if ((*it)->getDegradation() != 0.0)
+            {
+              mDecaying.push_back(k);
+            }
+
+          continue;
+        }
+
+      mDiffusing.push_back(k);
 
       if (tmp < mDeltaT)
         {
           mDeltaT = tmp;
         }
+
+      // The most negative eigenvalue of the stencil is reached for the checkerboard mode.
+      double Radius = (*it)->getDegradation() + RadiusWeight * (*it)->getDiffusion();
+
+      if (Radius > mSpectralRadius)
+        {
+          mSpectralRadius = Radius;
+        }
     }
-}
 
-void DiffuserImpl::computeVals1D(const double & deltaT)
-{
-  Iterator itPoint(repast::Point< int >(std::vector< int >(mShape.dimensionCount(), 0)), mShape);
+  if (mDiffusing.size() < mCytokines.size())
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": diffuser integrates " << mDiffusing.size()
+                         << " cytokines, decaying: " << mDecaying.size() << ", constant: "
+                         << mCytokines.size() - mDiffusing.size() - mDecaying.size() << std::endl;
+    }
+
+  mPlanes = mDiffusing;
 
-  std::vector< double > * pOldValueE = &mpCurrentValues->operator [](*itPoint);
-  itPoint.next();
-  std::vector< double > * pOldValue = &mpCurrentValues->operator [](*itPoint);
-  std::vector< double > * pNewValue = &mpNewValues->operator [](*itPoint);
-  itPoint.next();
-  std::vector< double > * pOldValueW = &mpCurrentValues->operator [](*itPoint);
+  // The explicit steps are used by the explicit and RKL solvers.
+  std::vector< double > Diffusion;
+  std::vector< double > Degradation;
 
-  while (itPoint)
+  for (it = mCytokines.begin(); it != end; ++it)
     {
-      std::vector< Cytokine * >::const_iterator it = mCytokines.begin();
-      std::vector< Cytokine * >::const_iterator end = mCytokines.end();
+      Diffusion.push_back((*it)->getDiffusion());
+      Degradation.push_back((*it)->getDegradation());
+    }
 
-      std::vector< double >::const_iterator itOldValueE = pOldValueE->begin();
-      std::vector< double >::const_iterator itOldValue = pOldValue->begin();
-      std::vector< double >::const_iterator itOldValueW = pOldValueW->begin();
-      std::vector< double >::iterator itNewValue = pNewValue->begin();
+  mpSweep = new ExplicitSweep(mShape.dimensionCount(), mKernel, mStencil3D, Diffusion, Degradation);
+  mpSweep->setThreads(mThreads);
 
-      // Boundaries are marked by NaN values;
-      if (std::isnan(*itOldValueE)) itOldValueE = itOldValue;
-      if (std::isnan(*itOldValueW)) itOldValueW = itOldValue;
+  // Diffusing cytokines may replace the time stepping by a steady state solve every steadyStateInterval ticks.
+  mSteadySolvers.resize(mCytokines.size(), NULL);
 
-      for (; it != end; ++it, ++itOldValueE, ++itOldValue, ++itOldValueW, ++itNewValue)
+  for (it = mCytokines.begin(); it != end; ++it)
+    {
+      if ((*it)->getSteadyStateInterval() == 0 ||
+          (*it)->getDiffusion() == 0.0)
         {
-          *itNewValue = deltaT * (*it)->getDiffusion() * (*itOldValueE + *itOldValueW) + (1.0 - deltaT * ((*it)->getDegradation() + 2.0 * (*it)->getDiffusion())) * *itOldValue;
+          continue;
         }
 
-      pNewValue = &mpNewValues->operator [](*itPoint);
+      if (mShape.dimensionCount() != 2)
+        {
+          LocalFile::debug() << mpCompartment->getName() << ": steady state of " << (*it)->getName()
+                             << " requires 2D, using time stepping." << std::endl;
+          continue;
+        }
 
-      itPoint.next();
+      Multigrid * pSolver = new Multigrid(mShape[Borders::X], mShape[Borders::Y], (*it)->getDiffusion(), (*it)->getDegradation());
+      mSteadySolvers[it - mCytokines.begin()] = pSolver;
 
-      pOldValueE = pOldValue;
-      pOldValue = pOldValueW;
-      pOldValueW = &mpCurrentValues->operator [](*itPoint);
+      LocalFile::debug() << mpCompartment->getName() << ": steady state of " << (*it)->getName() << " every "
+                         << (*it)->getSteadyStateInterval() << " ticks, multigrid levels: " << pSolver->levels() << std::endl;
     }
 
-  // Swap current and new values
-  DenseMatrix< std::vector< double > > * pTmp = mpCurrentValues;
-  mpCurrentValues = mpNewValues;
-  mpNewValues = pTmp;
-}
+  if (std::count(mSteadySolvers.begin(), mSteadySolvers.end(), (Multigrid *) NULL) < (ptrdiff_t) mSteadySolvers.size())
+    {
+      // The steady values hold the values after the last tick, i.e., the difference to the current values are the secretions.
+      mpSteadyValues = new ValuePlanes(*mpDiffuserData->getLocalValues());
 
-void DiffuserImpl::computeVals2D(const double & deltaT)
-{
-  *mpNewValues = *mpCurrentValues;
+      if (!pRun->getValue("diffuser.multigrid.cycles", mSteadyCycles) ||
+          mSteadyCycles < 1)
+        {
+          mSteadyCycles = 20;
+        }
 
-  Iterator itNorth(repast::Point< int >(std::vector< int >(mShape.dimensionCount(), 0)), mShape);
+      if (!pRun->getValue("diffuser.multigrid.tolerance", mSteadyTolerance) ||
+          mSteadyTolerance <= 0.0)
+        {
+          mSteadyTolerance = 1e-6;
+        }
+    }
 
-  std::vector< double > * pOldValueNE = &mpCurrentValues->operator [](*itNorth);
-  itNorth.next();
-  std::vector< double > * pOldValueN = &mpCurrentValues->operator [](*itNorth);
-  itNorth.next();
-  std::vector< double > * pOldValueNW = &mpCurrentValues->operator [](*itNorth);
+  if (mSolver == RKL)
+    {
+      mpPreviousValues = new ValuePlanes(*mpDiffuserData->getLocalValues());
+    }
 
-  Iterator itPoint(repast::Point< int >(std::vector< int >(mShape.dimensionCount(), 0)), mShape);
-  itPoint.next(1); // Move 1 row down
+  if (mSolver != ADI &&
+      mShape.dimensionCount() == 2)
+    {
+      // A tile size of 0 is determined by the autotuner.
+      int TileX = 0;
+      int TileY = 0;
+      pRun->getValue("diffuser.tile.x", TileX);
+      pRun->getValue("diffuser.tile.y", TileY);
+      mpSweep->setTile(TileX, TileY);
+      pRun->getValue("diffuser.fuse", mFuseSteps);
 
-  std::vector< double > * pOldValueE = &mpCurrentValues->operator [](*itPoint);
-  itPoint.next();
-  std::vector< double > * pOldValue = &mpCurrentValues->operator [](*itPoint);
-  std::vector< double > * pNewValue = &mpNewValues->operator [](*itPoint);
-  itPoint.next();
-  std::vector< double > * pOldValueW = &mpCurrentValues->operator [](*itPoint);
+      // Fusing is only possible for the explicit solver as RKL synchronizes after each stage.
+      if (mSolver != EXPLICIT)
+        {
+          mFuseSteps = false;
+        }
 
-  Iterator itSouth(repast::Point< int >(std::vector< int >(mShape.dimensionCount(), 0)), mShape);
-  itSouth.next(1); itSouth.next(1); // Move 2 rows down
+      autotuneTiles();
 
-  std::vector< double > * pOldValueSE = &mpCurrentValues->operator [](*itSouth);
-  itSouth.next();
-  std::vector< double > * pOldValueS = &mpCurrentValues->operator [](*itSouth);
-  itSouth.next();
-  std::vector< double > * pOldValueSW = &mpCurrentValues->operator [](*itSouth);
+      // Tiles where all cytokines are below epsilon only decay, 0 disables the check.
+      if (!pRun->getValue("diffuser.epsilon", mEpsilon) ||
+          mEpsilon < 0.0)
+        {
+          mEpsilon = 0.0;
+        }
 
-  while (itSouth)
-    {
-      std::vector< Cytokine * >::const_iterator it = mCytokines.begin();
-      std::vector< Cytokine * >::const_iterator end = mCytokines.end();
+      mpSweep->setEpsilon(mEpsilon);
 
-      std::vector< double >::const_iterator itOldValueE = pOldValueE->begin();
-      std::vector< double >::const_iterator itOldValue = pOldValue->begin();
-      std::vector< double >::const_iterator itOldValueW = pOldValueW->begin();
-      std::vector< double >::iterator itNewValue = pNewValue->begin();
+      if (mEpsilon > 0.0)
+        {
+          LocalFile::debug() << mpCompartment->getName() << ": diffuser skips tiles below: " << mEpsilon << std::endl;
+        }
+    }
 
-      // Boundaries are marked by NaN values;
-      if (std::isnan(*itOldValueE)) itOldValueE = itOldValue;
-      if (std::isnan(*itOldValueW)) itOldValueW = itOldValue;
+  // On request the explicit steps overlap the halo exchange with the update of the interior, which requires
+  // at least 3 cells in each dimension.
+  if (mSolver == EXPLICIT &&
+      !(mFuseSteps && mShape.dimensionCount() == 2))
+    {
+      pRun->getValue("diffuser.overlap", mOverlap);
 
+      for (size_t d = 0; d < mShape.dimensionCount(); ++d)
+        if (mShape[d] < 3)
+          mOverlap = false;
 
-      std::vector< double >::const_iterator itOldValueNE = pOldValueNE->begin();
-      std::vector< double >::const_iterator itOldValueN = pOldValueN->begin();
-      std::vector< double >::const_iterator itOldValueNW = pOldValueNW->begin();
+      LocalFile::debug() << mpCompartment->getName() << ": diffuser overlaps halo exchange: " << (mOverlap ? "yes" : "no") << std::endl;
+    }
+
+  if (mSolver == ADI)
+    {
+      // The processes sharing our rows and columns; the local grids have all the same shape.
+      const repast::GridDimensions & Dimensions = mpCompartment->diffuserDimensions();
+      const repast::Point< int > & Origin = mpDiffuserData->origin();
 
-      // Boundaries are marked by NaN values;
-      if (std::isnan(*itOldValueN)) itOldValueN = itOldValue;
-      if (std::isnan(*itOldValueNE)) itOldValueNE = itOldValueE;
-      if (std::isnan(*itOldValueNE)) itOldValueNE = itOldValueN;
-      if (std::isnan(*itOldValueNW)) itOldValueNW = itOldValueW;
-      if (std::isnan(*itOldValueNW)) itOldValueNW = itOldValueN;
+      int ProcessesX = round(Dimensions.extents(Borders::X) / mShape[Borders::X]);
+      int ProcessesY = round(Dimensions.extents(Borders::Y) / mShape[Borders::Y]);
 
-      std::vector< double >::const_iterator itOldValueSE = pOldValueSE->begin();
-      std::vector< double >::const_iterator itOldValueS = pOldValueS->begin();
-      std::vector< double >::const_iterator itOldValueSW = pOldValueSW->begin();
+      std::vector< int > RowRanks;
+      std::vector< int > ColumnRanks;
+      std::vector< int > Location = Origin.coords();
 
-      for (; it != end; ++it, ++itOldValueNE, ++itOldValueN, ++itOldValueNW, ++itOldValueE, ++itOldValue, ++itOldValueW, ++itOldValueSE, ++itOldValueS, ++itOldValueSW, ++itNewValue)
+      for (int i = 0; i < ProcessesX; ++i)
         {
-          double Average = (*itOldValueNE + *itOldValueNW + *itOldValueSE + *itOldValueSW + 4.0 * (*itOldValueN + *itOldValueE + *itOldValueW  + *itOldValueS)) * 0.3;
-          *itNewValue = deltaT * (*it)->getDiffusion() * Average + (1.0 - deltaT * ((*it)->getDegradation() + 6.0 * (*it)->getDiffusion())) * *itOldValue;
+          Location[Borders::X] = round(Dimensions.origin(Borders::X)) + i * mShape[Borders::X];
+          RowRanks.push_back(mpCompartment->getRank(mpCompartment->diffuserToGrid(Location)));
         }
 
-      do
+      Location = Origin.coords();
+
+      for (int i = 0; i < ProcessesY; ++i)
         {
-          pNewValue = &mpNewValues->operator [](*itPoint);
+          Location[Borders::Y] = round(Dimensions.origin(Borders::Y)) + i * mShape[Borders::Y];
+          ColumnRanks.push_back(mpCompartment->getRank(mpCompartment->diffuserToGrid(Location)));
+        }
 
-          itPoint.next();
+      MPI_Comm Communicator = *repast::RepastProcess::instance()->getCommunicator();
 
-          pOldValueE = pOldValue;
-          pOldValue = pOldValueW;
-          pOldValueW = &mpCurrentValues->operator [](*itPoint);
+      mRowCommunicator = TridiagonalSolver::createCommunicator(Communicator, RowRanks, Borders::X);
+      mColumnCommunicator = TridiagonalSolver::createCommunicator(Communicator, ColumnRanks, Borders::Y);
+    }
+}
 
-          itNorth.next();
+void DiffuserImpl::autotuneTiles()
+{
+  static const int Candidates[] = {0, 1024, 512, 256, 128, 64, 32, 16, 8, -1};
 
-          pOldValueNE = pOldValueN;
-          pOldValueN = pOldValueNW;
-          pOldValueNW = &mpCurrentValues->operator [](*itNorth);
+  // The shapes selected by the autotuner of the process. The key is the local shape, the count of swept
+  // planes, the fused steps, and the requested tile size, which are the same on all processes.
+  static std::map< std::vector< int >, std::pair< int, int > > Selected;
 
-          itSouth.next();
+  const int & Halo = mpDiffuserData->getLocalValues()->halo();
+  const int Steps = mFuseSteps ? Halo : 1;
+  const int Width = mShape[0];
+  const int Height = mShape[1];
+  int TileX = mpSweep->getTileX();
+  int TileY = mpSweep->getTileY();
 
-          if (!itSouth)
-            {
-              break;
-            }
+  // A tile size requested in both dimensions is used as is.
+  if (TileX > 0 && TileY > 0)
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": diffuser tile: " << TileX << " x " << TileY
+                         << " (fused steps: " << Steps << ", requested)" << std::endl;
+      return;
+    }
 
-          pOldValueSE = pOldValueS;
-          pOldValueS = pOldValueSW;
-          pOldValueSW = &mpCurrentValues->operator [](*itSouth);
-        }
-      while(itPoint->getX() == 0 || itPoint->getX() == 1);
+  std::vector< int > Key;
+  Key.push_back(Width);
+  Key.push_back(Height);
+  Key.push_back(mPlanes.size());
+  Key.push_back(Steps);
+  Key.push_back(TileX);
+  Key.push_back(TileY);
+
+  std::map< std::vector< int >, std::pair< int, int > >::const_iterator found = Selected.find(Key);
+
+  if (found != Selected.end())
+    {
+      TileX = found->second.first;
+      TileY = found->second.second;
+      mpSweep->setTile(TileX, TileY);
+
+      LocalFile::debug() << mpCompartment->getName() << ": diffuser tile: "
+                         << (TileX > 0 ? TileX : Width) << " x " << (TileY > 0 ? TileY : Height)
+                         << " (fused steps: " << Steps << ", cached)" << std::endl;
+      return;
     }
 
-  *mpCurrentValues = *mpNewValues;
-}
+  std::vector< int > TilesX;
+  std::vector< int > TilesY;
 
-void DiffuserImpl::computeVals3D(const double & /* deltaT */)
-{
-  // TODO Implement me
+  for (const int * pCandidate = Candidates; *pCandidate >= 0; ++pCandidate)
+    {
+      if (*pCandidate < Width) TilesX.push_back(*pCandidate);
+      if (*pCandidate < Height) TilesY.push_back(*pCandidate);
+    }
+
+  if (TileX > 0) TilesX.assign(1, TileX);
+  if (TileY > 0) TilesY.assign(1, TileY);
+
+  // The first process times the candidates and broadcasts its selection, i.e., all processes use the
+  // same shape. All processes create the diffusers of the compartments in the same order.
+  int Best[2] = {TilesX[0], TilesY[0]};
+  double BestTime = std::numeric_limits< double >::infinity();
+
+  MPI_Comm Communicator = *repast::RepastProcess::instance()->getCommunicator();
+
+  if (repast::RepastProcess::instance()->rank() == 0)
+    {
+      // The sweeps operate on scratch planes, i.e., the diffuser data is not modified.
+      ValuePlanes Current(mShape, mCytokines.size(), Halo, 1.0);
+      ValuePlanes Next(mShape, mCytokines.size(), Halo, 0.0);
+
+      std::vector< int >::const_iterator itX = TilesX.begin();
+      std::vector< int >::const_iterator endX = TilesX.end();
+      std::vector< int >::const_iterator itY;
+      std::vector< int >::const_iterator endY = TilesY.end();
+
+      for (; itX != endX; ++itX)
+        for (itY = TilesY.begin(); itY != endY; ++itY)
+          {
+            mpSweep->setTile(*itX, *itY);
+
+            // The fastest of a few repetitions is least affected by noise.
+            double Time = std::numeric_limits< double >::infinity();
+
+            for (int i = 0; i < 3; ++i)
+              {
+                double Start = MPI_Wtime();
+                mpSweep->sweep(Current, Next, mPlanes, mDeltaT, Steps, extent(Halo - Steps));
+                Time = std::min(Time, MPI_Wtime() - Start);
+              }
+
+            if (Time < BestTime)
+              {
+                BestTime = Time;
+                Best[0] = *itX;
+                Best[1] = *itY;
+              }
+          }
+    }
+
+  MPI_Bcast(Best, 2, MPI_INT, 0, Communicator);
+  MPI_Bcast(&BestTime, 1, MPI_DOUBLE, 0, Communicator);
+
+  TileX = Best[0];
+  TileY = Best[1];
+  mpSweep->setTile(TileX, TileY);
+  mpSweep->resetTiles();
+
+  Selected[Key] = std::make_pair(TileX, TileY);
+
+  LocalFile::debug() << mpCompartment->getName() << ": diffuser tile: "
+                     << (TileX > 0 ? TileX : Width) << " x " << (TileY > 0 ? TileY : Height)
+                     << " (fused steps: " << Steps << ", sweep: " << BestTime << " s, candidates: "
+                     << TilesX.size() * TilesY.size() << ")" << std::endl;
 }
 
 /**
- * Computes all the values for the space.
+ * Computes all the values for the space including the given number of ghost cell layers.
  */
-void DiffuserImpl::computeVals(const double & deltaT)
+void DiffuserImpl::computeVals(const double & deltaT, const int & ghosts)
 {
-  switch (mShape.dimensionCount())
-  {
-    case 1:
-      computeVals1D(deltaT);
-      break;
-
-    case 2:
-      computeVals2D(deltaT);
-      break;
-
-    case 3:
-      computeVals3D(deltaT);
-      break;
-  }
+  computeRegion(deltaT, extent(ghosts));
+
+  // Cells of the next values outside the updated region are stale, they are
+  // never read before the next synchronization overwrites the ghost ring.
+  mpDiffuserData->flipLocalValues();
 }
 
-void DiffuserImpl::diffuse(const double & deltaT)
+void DiffuserImpl::computeRegion(const double & deltaT, const Region & region)
 {
-  size_t steps = ceil(deltaT/mDeltaT);
-  double DeltaT = deltaT/steps;
+  mpSweep->sweep(*mpDiffuserData->getLocalValues(), *mpDiffuserData->getNextValues(), mPlanes, deltaT, 1, region);
+}
 
-  // Do integration steps to reach deltaT
-  for (size_t s = 0; s < steps; ++s)
+DiffuserImpl::Region DiffuserImpl::extent(const int & ghosts) const
+{
+  Region Extent;
+
+  for (size_t d = 0; d < 3; ++d)
     {
-      computeVals(DeltaT);
+      Extent.lower[d] = 0;
+      Extent.upper[d] = 1;
+    }
 
-      mpCompartment->synchronizeDiffuser();
+  for (size_t d = 0; d < mShape.dimensionCount(); ++d)
+    {
+      Extent.lower[d] = -ghosts;
+      Extent.upper[d] = mShape[d] + ghosts;
+    }
 
-      // mpDiffuserData->write(LocalFile::instance(mpCompartment->getName())->stream(), "\t", mpCompartment);
+  return Extent;
+}
+
+void DiffuserImpl::partition(const Region & extent, Region & interior, std::vector< Region > & boundary) const
+{
+  // The stencils reach one cell, i.e., the cells [1, shape - 1) read only owned cells. The strips are cut
+  // dimension by dimension from the remaining region, which shrinks to the interior.
+  interior = extent;
+  boundary.clear();
+
+  for (size_t d = mShape.dimensionCount(); d-- > 0;)
+    {
+      Region Strip = interior;
+      Strip.upper[d] = 1;
+      boundary.push_back(Strip);
+
+      Strip = interior;
+      Strip.lower[d] = mShape[d] - 1;
+      boundary.push_back(Strip);
+
+      interior.lower[d] = 1;
+      interior.upper[d] = mShape[d] - 1;
     }
 }
 
-#ifdef XXXX
-  /* this is being based on
-   http://www.mathcs.sjsu.edu/faculty/rucker/capow/santafe.html */
-  int size = _dimensions.dimensionCount();
+void DiffuserImpl::createLineSolvers(const double & deltaT)
+{
+  deleteLineSolvers();
 
-  if (size == 3)
+  const Borders * pBorders = mpCompartment->diffuserBorders();
+  bool PeriodicX = pBorders->getBorderType(Borders::X, Borders::LOW) == Borders::WRAP;
+  bool PeriodicY = pBorders->getBorderType(Borders::Y, Borders::LOW) == Borders::WRAP;
+
+  std::vector< Cytokine * >::const_iterator it = mCytokines.begin();
+  std::vector< Cytokine * >::const_iterator end = mCytokines.end();
+
+  for (; it != end; ++it)
+    {
+      // The weighted 9 point stencil of the explicit scheme corresponds to the diffusion
+      // coefficient 1.8 * D for the 5 point Laplacian. The degradation is split evenly
+      // between the two directions.
+      const double r = 0.5 * deltaT * 1.8 * (*it)->getDiffusion();
+      const double Diagonal = 1.0 + 2.0 * r + 0.25 * deltaT * (*it)->getDegradation();
+
+      mRowSolvers.push_back(new TridiagonalSolver(mRowCommunicator, PeriodicX, mShape[Borders::X], Diagonal, r));
+      mColumnSolvers.push_back(new TridiagonalSolver(mColumnCommunicator, PeriodicY, mShape[Borders::Y], Diagonal, r));
+    }
+
+  mLineSolverDeltaT = deltaT;
+}
+
+void DiffuserImpl::deleteLineSolvers()
+{
+  std::vector< TridiagonalSolver * >::iterator it = mRowSolvers.begin();
+  std::vector< TridiagonalSolver * >::iterator end = mRowSolvers.end();
+
+  for (; it != end; ++it)
+    delete *it;
+
+  for (it = mColumnSolvers.begin(), end = mColumnSolvers.end(); it != end; ++it)
+    delete *it;
+
+  mRowSolvers.clear();
+  mColumnSolvers.clear();
+}
+
+void DiffuserImpl::computeADI2D(const double & deltaT)
+{
+  if (deltaT != mLineSolverDeltaT)
+    {
+      createLineSolvers(deltaT);
+    }
+
+  const ValuePlanes * pCurrentValues = mpDiffuserData->getLocalValues();
+  ValuePlanes * pNewValues = mpDiffuserData->getNextValues();
+
+  const int xmax = mShape[0];
+  const int ymax = mShape[1];
+  const ptrdiff_t Stride = pNewValues->stride();
+
+  mRightHandSide.resize(xmax * ymax);
+
+  std::vector< size_t >::const_iterator it = mPlanes.begin();
+  std::vector< size_t >::const_iterator end = mPlanes.end();
+
+  for (; it != end; ++it)
     {
-      int width = _dimensions.extents().getX();
-      int height = _dimensions.extents().getY();
-      int depth = _dimensions.extents().getZ();
+      const size_t & k = *it;
+      const double r = 0.5 * deltaT * 1.8 * mCytokines[k]->getDiffusion();
+      const double Center = 1.0 - 2.0 * r - 0.25 * deltaT * mCytokines[k]->getDegradation();
 
-      vec3d newVals(width, vec2d(depth, vec1d(height)));
+      // First half step: explicit in y (the ghost rows hold the boundary values), implicit in x
+      double * pRightHandSide = &mRightHandSide[0];
 
-      for (int z = 0; z < depth; z++)
+      for (int y = 0; y < ymax; ++y)
         {
-          for (int y = 0; y < height; y++)
+          const double * pOldValueN = pCurrentValues->row(k, y - 1);
+          const double * pOldValue = pCurrentValues->row(k, y);
+          const double * pOldValueS = pCurrentValues->row(k, y + 1);
+          double * pNewValue = pNewValues->row(k, y);
+
+          for (int x = 0; x < xmax; ++x, ++pRightHandSide)
             {
-              for (int x = 0; x < width; x++)
-                {
-                  newVals[x][y][z] = compute3dVal(x, y, z);
-                }
+              *pRightHandSide = r * (pOldValueN[x] + pOldValueS[x]) + Center * pOldValue[x];
+              pNewValue[x] = *pRightHandSide;
             }
         }
-      _computed3dVals = newVals;
+
+      mRowSolvers[k]->solve(pNewValues->row(k, 0), ymax, Stride, 1);
+
+      // Second half step: explicit in x, implicit in y. The explicit part is derived from the
+      // first half step, i.e., (1 + Ax) u* = 2 u* - (1 - Ax) u*, which avoids a synchronization.
+      pRightHandSide = &mRightHandSide[0];
+
+      for (int y = 0; y < ymax; ++y)
+        {
+          double * pNewValue = pNewValues->row(k, y);
+
+          for (int x = 0; x < xmax; ++x, ++pRightHandSide)
+            {
+              pNewValue[x] = 2.0 * pNewValue[x] - *pRightHandSide;
+            }
+        }
+
+      mColumnSolvers[k]->solve(pNewValues->row(k, 0), xmax, 1, Stride);
+    }
+
+  mpDiffuserData->flipLocalValues();
+}
+
+size_t DiffuserImpl::diffuseRKL(const double & deltaT)
+{
+  // We keep a safety margin of 10% to the stability limit since the extreme mode is not damped at the limit.
+  size_t Stages = 1;
+
+  while (Stages * Stages + Stages < 1.1 * deltaT * mSpectralRadius)
+    {
+      Stages++;
+    }
+
+  if (Stages != mStages)
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": RKL stages: " << Stages
+                         << " (explicit steps: " << ceil(deltaT / mDeltaT) << ")" << std::endl;
+      mStages = Stages;
+    }
+
+  const double Denominator = Stages * Stages + Stages;
+  const int Cytokines = mPlanes.size();
+  const int Rows = mShape.dimensionCount() > 1 ? mShape[1] : 1;
+  const int Layers = mShape.dimensionCount() > 2 ? mShape[2] : 1;
+  const int xmax = mShape[0];
+
+  // Y[j] = mu[j] * Y[j-1] + nu[j] * Y[j-2] + muTilde[j] * deltaT * M(Y[j-1]) with mu[j] + nu[j] = 1.
+  // The forward Euler step computeVals(muTilde[j] * deltaT) provides Y[j-1] + muTilde[j] * deltaT * M(Y[j-1]),
+  // i.e., we only need to add nu[j] * (Y[j-2] - Y[j-1]). After the step Y[j-1] is still available as the
+  // next values of the diffuser data and only its interior is saved as Y[j-2] for the following stage.
+  for (size_t j = 1; j <= Stages; ++j)
+    {
+      const double MuTilde = 2.0 * (2.0 * j - 1.0) / (j * Denominator);
+      const double Nu = -(j - 1.0) / j;
+
+      computeVals(MuTilde * deltaT, 0);
+
+      const ValuePlanes * pStageValues = mpDiffuserData->getNextValues();
+      ValuePlanes * pCurrentValues = mpDiffuserData->getLocalValues();
+
+#pragma omp parallel for num_threads(mThreads) schedule(static)
+      for (int r = 0; r < Rows * Layers; ++r)
+        for (int i = 0; i < Cytokines; ++i)
+          {
+            const size_t & k = mPlanes[i];
+            double * pValue = pCurrentValues->row(k, r % Rows, r / Rows);
+            double * pPrevious = mpPreviousValues->row(k, r % Rows, r / Rows);
+            const double * pStage = pStageValues->row(k, r % Rows, r / Rows);
+
+            if (j > 1)
+              {
+                for (int x = 0; x < xmax; ++x)
+                  {
+                    pValue[x] += Nu * (pPrevious[x] - pStage[x]);
+                  }
+              }
+
+            if (j < Stages)
+              {
+                memcpy(pPrevious, pStage, xmax * sizeof(double));
+              }
+          }
+
+      // Each stage requires the ghost ring of Y[j-1].
+      mpCompartment->synchronizeDiffuser(false);
+    }
+
+  // Each stage flips the values once.
+  return Stages;
+}
+
+void DiffuserImpl::diffuse(const double & deltaT)
+{
+  // The ghost rings of decaying fields decay exactly like the owned cells, i.e., they need no exchange.
+  decay(deltaT);
+
+  if (mDiffusing.empty()) return;
+
+  // The cytokines due for a steady state solve are not time stepped.
+  std::vector< size_t > Steady;
+  std::vector< size_t > Stepped;
+  std::vector< size_t >::const_iterator it = mDiffusing.begin();
+  std::vector< size_t >::const_iterator end = mDiffusing.end();
+
+  // The source of the steady state is the change over a tick, i.e., the first solve is after the first tick.
+  for (; it != end; ++it)
+    {
+      if (mSteadySolvers[*it] != NULL &&
+          mTick > 0 &&
+          mTick % mCytokines[*it]->getSteadyStateInterval() == 0)
+        {
+          Steady.push_back(*it);
+        }
+      else
+        {
+          Stepped.push_back(*it);
+        }
+    }
+
+  ++mTick;
+
+  // Only the planes of diffusing cytokines change, i.e., the neighbors need only those.
+  mPlanes = Stepped;
+
+  if (mPlanes.empty())
+    {
+      // Nothing to time step
+    }
+  else if (mSolver == RKL)
+    {
+      if (mPlanes.size() < mCytokines.size())
+        {
+          mpDiffuserData->setExchangedPlanes(mPlanes);
+        }
+
+      // The stages cover deltaT in a single super step.
+      restorePlanes(diffuseRKL(deltaT));
+      logSkippedTiles();
+    }
+  else if (mSolver == ADI)
+    {
+      if (mPlanes.size() < mCytokines.size())
+        {
+          mpDiffuserData->setExchangedPlanes(mPlanes);
+        }
+
+      // The implicit solver covers deltaT in a single step.
+      computeADI2D(deltaT);
+      restorePlanes(1);
+      mpCompartment->synchronizeDiffuser(false);
+    }
+  else
+    {
+      // The cytokines are grouped by the number of steps needed for a stable integration over deltaT,
+      // i.e., slowly diffusing cytokines are not forced to the step size of the fastest one.
+      std::map< size_t, std::vector< size_t > > Groups;
+
+      for (it = Stepped.begin(), end = Stepped.end(); it != end; ++it)
+        {
+          Groups[ceil(deltaT/mStableDeltaT[*it])].push_back(*it);
+        }
+
+      integrate(deltaT, Groups);
+      logSkippedTiles();
+    }
+
+  if (!Steady.empty())
+    {
+      solveSteadyState(deltaT, Steady);
+    }
+
+  mPlanes = mDiffusing;
+  mpDiffuserData->setExchangedPlanes(std::vector< size_t >());
+
+  if (mpSteadyValues != NULL)
+    {
+      for (size_t k = 0; k < mSteadySolvers.size(); ++k)
+        if (mSteadySolvers[k] != NULL)
+          mpSteadyValues->copyPlane(k, *mpDiffuserData->getLocalValues());
     }
 }
 
-double DiffuserImpl::compute3dVal(int xCoord, int yCoord, int zCoord)
+void DiffuserImpl::solveSteadyState(const double & deltaT, const std::vector< size_t > & planes)
 {
+  ValuePlanes * pValues = mpDiffuserData->getLocalValues();
+  const ptrdiff_t Stride = pValues->stride();
+  const int xmax = mShape[Borders::X];
+  const int ymax = mShape[Borders::Y];
+
+  // The source rate is the change since the last tick, i.e., the secretions, which are already added.
+  // It replaces the stored values of the last tick.
+  std::vector< size_t >::const_iterator it = planes.begin();
+  std::vector< size_t >::const_iterator end = planes.end();
 
-  double weightedSum = 0;
-  int numberEqual = 0;
-  /* this is 4 if we're dealing with a direct (von-neuman) neighbor of the
-   cell otherwise (we're on a diagonal) it's 1 */
-  int multiplier = 1;
-  /* this keeps the count of the number of neighbors we found that are valid.
-   this also takes into account that some of the cells are weighted more
-   than others and will have them counted accordingly (4 versus 1) */
-  int count = 0;
-  for (int z = zCoord - 1; z <= zCoord + 1; z++)
-    {
-      for (int y = yCoord - 1; y <= yCoord + 1; y++)
+  for (; it != end; ++it)
+    for (int y = 0; y < ymax; ++y)
+      {
+        const double * pValue = pValues->row(*it, y);
+        double * pSource = mpSteadyValues->row(*it, y);
+
+        for (int x = 0; x < xmax; ++x)
+          {
+            pSource[x] = (pValue[x] - pSource[x]) / deltaT;
+          }
+      }
+
+  mPlanes = planes;
+
+  if (mPlanes.size() < mCytokines.size())
+    {
+      mpDiffuserData->setExchangedPlanes(mPlanes);
+    }
+
+  // Each rank does V-cycles on its subdomain with the ghost ring as boundary values. The exchange of the
+  // ghost rings between the cycles couples the subdomains (additive Schwarz).
+  // The process dimensions cover all processes, i.e., every process holds a diffuser for the compartment
+  // and takes part in the reduction of the residuals. All processes thus do the same number of cycles.
+  MPI_Comm Communicator = *repast::RepastProcess::instance()->getCommunicator();
+  std::vector< double > First(planes.size(), 0.0);
+  std::vector< double > Last(planes.size(), 0.0);
+  int Cycles = 0;
+  bool Converged = false;
+
+  while (!Converged &&
+         Cycles < mSteadyCycles)
+    {
+      // The residual is the maximum norm before the cycle.
+      for (size_t i = 0; i < planes.size(); ++i)
         {
-          for (int x = xCoord - 1; x <= xCoord + 1; x++)
+          Last[i] = mSteadySolvers[planes[i]]->cycle(pValues->plane(planes[i]), mpSteadyValues->plane(planes[i]), Stride);
+        }
+
+      ++Cycles;
+      mpCompartment->synchronizeDiffuser(false);
+
+      MPI_Allreduce(MPI_IN_PLACE, &Last[0], Last.size(), MPI_DOUBLE, MPI_MAX, Communicator);
+
+      if (Cycles == 1)
+        {
+          First = Last;
+        }
+
+      Converged = true;
+
+      for (size_t i = 0; i < planes.size(); ++i)
+        if (Last[i] > mSteadyTolerance * First[i])
+          Converged = false;
+    }
+
+  for (size_t i = 0; i < planes.size(); ++i)
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": steady state of " << mCytokines[planes[i]]->getName()
+                         << " residual: " << First[i] << " -> " << Last[i] << " (" << Cycles << " cycles"
+                         << (Converged ? "" : ", not converged") << ")" << std::endl;
+    }
+}
+
+void DiffuserImpl::decay(const double & deltaT)
+{
+  ValuePlanes * pValues = mpDiffuserData->getLocalValues();
+  std::vector< size_t >::const_iterator it = mDecaying.begin();
+  std::vector< size_t >::const_iterator end = mDecaying.end();
+
+  for (; it != end; ++it)
+    {
+      pValues->scale(*it, exp(-deltaT * mCytokines[*it]->getDegradation()));
+    }
+}
+
+void DiffuserImpl::restorePlanes(const size_t & flips)
+{
+  if (flips % 2 == 0 ||
+      mPlanes.size() == mCytokines.size())
+    {
+      return;
+    }
+
+  // After an odd number of flips the planes which were not updated are only valid in the
+  // next values. We copy the updated planes instead of flipping back.
+  for (size_t i = 0; i < mPlanes.size(); ++i)
+    {
+      mpDiffuserData->getNextValues()->copyPlane(mPlanes[i], *mpDiffuserData->getLocalValues());
+    }
+
+  mpDiffuserData->flipLocalValues();
+}
+
+void DiffuserImpl::integrate(const double & deltaT, const std::map< size_t, std::vector< size_t > > & groups)
+{
+  // The groups are interleaved: group g does its steps g in the first g substeps of the largest group,
+  // i.e., each synchronization serves all groups still active. The planes are independent, i.e., the
+  // order of the steps of different groups does not matter.
+  std::map< size_t, std::vector< size_t > >::const_iterator itGroup;
+  std::map< size_t, std::vector< size_t > >::const_iterator endGroup = groups.end();
+
+  const size_t Steps = groups.rbegin()->first;
+  size_t Flips = 0;
+
+  // The flips after which the planes of each group are final, which are valid in the current values
+  // after an even number of further flips.
+  std::map< size_t, size_t > FinalFlips;
+
+  // A ghost ring of width halo allows up to halo integration steps between synchronizations.
+  // Each step invalidates the outermost layer of ghost cells, i.e., the updated region shrinks
+  // by one cell per step until only the interior is valid.
+  const int & Halo = mpDiffuserData->getLocalValues()->halo();
+
+  // With overlap the synchronization after a block of steps is only started. The first step of the next
+  // block updates the interior while the halo is in flight and the boundary strip once it is finished.
+  // The secretions were applied before the integration, i.e., finishing changes only the ghost ring.
+  bool Pending = false;
+  std::vector< double > Waits;
+
+  // Do integration steps to reach deltaT
+  for (size_t s = 0; s < Steps;)
+    {
+      // The planes of the groups active at the start of the block are exchanged at its end. A group
+      // finishing within the block is carried to the next values by the remaining steps of the block.
+      std::vector< size_t > Planes;
+
+      for (itGroup = groups.upper_bound(s); itGroup != endGroup; ++itGroup)
+        {
+          Planes.insert(Planes.end(), itGroup->second.begin(), itGroup->second.end());
+        }
+
+      std::sort(Planes.begin(), Planes.end());
+
+      if (mFuseSteps && mShape.dimensionCount() == 2)
+        {
+          // The steps between synchronizations are done tile by tile.
+          const size_t Block = std::min< size_t >(Halo, Steps - s);
+
+          for (itGroup = groups.upper_bound(s); itGroup != endGroup; ++itGroup)
             {
-              numberEqual = 0;
-              /* find out if we're directly north/south/east/west/above/below the
-               given cell (a von-neuman neighbor) */
-              if (xCoord == x)
-                {
-                  numberEqual++;
-                }
-              if (yCoord == y)
-                {
-                  numberEqual++;
-                }
-              if (zCoord == z)
-                {
-                  numberEqual++;
-                }
-              if (numberEqual == 3)
-                {
-                  /* we're at the source */
-                  continue;
-                }
-              else if (numberEqual == 2)
+              int GroupSteps = std::min(Block, itGroup->first - s);
+              mPlanes = itGroup->second;
+              mpSweep->sweep(*mpDiffuserData->getLocalValues(), *mpDiffuserData->getNextValues(), mPlanes,
+                             deltaT / itGroup->first, GroupSteps, extent(Halo - GroupSteps));
+            }
+
+          mpDiffuserData->flipLocalValues();
+          s += Block;
+          ++Flips;
+        }
+      else
+        {
+          for (int ghosts = Halo - 1; ghosts >= 0 && s < Steps; --ghosts, ++s)
+            {
+              if (Pending)
                 {
-                  /* we're a direct neighbor so we get weighted more */
-                  multiplier = 4;
+                  Region Interior;
+                  std::vector< Region > Boundary;
+                  partition(extent(ghosts), Interior, Boundary);
+
+                  for (itGroup = groups.upper_bound(s); itGroup != endGroup; ++itGroup)
+                    {
+                      mPlanes = itGroup->second;
+                      computeRegion(deltaT / itGroup->first, Interior);
+                    }
+
+                  Waits.push_back(mpCompartment->finishSynchronizeDiffuser());
+                  Pending = false;
+
+                  std::vector< Region >::const_iterator itStrip;
+                  std::vector< Region >::const_iterator endStrip = Boundary.end();
+
+                  for (itGroup = groups.upper_bound(s); itGroup != endGroup; ++itGroup)
+                    {
+                      mPlanes = itGroup->second;
+
+                      for (itStrip = Boundary.begin(); itStrip != endStrip; ++itStrip)
+                        {
+                          computeRegion(deltaT / itGroup->first, *itStrip);
+                        }
+                    }
                 }
               else
                 {
-                  multiplier = 1;
+                  for (itGroup = groups.upper_bound(s); itGroup != endGroup; ++itGroup)
+                    {
+                      mPlanes = itGroup->second;
+                      computeRegion(deltaT / itGroup->first, extent(ghosts));
+                    }
                 }
-              weightedSum += multiplier * getCoordValue(Coords(x, y, z));
-              count += multiplier;
+
+              // The groups which finished earlier in the block are carried.
+              for (itGroup = groups.begin(); itGroup != endGroup && itGroup->first <= s; ++itGroup)
+                if (FinalFlips.find(itGroup->first) == FinalFlips.end())
+                  for (size_t i = 0; i < itGroup->second.size(); ++i)
+                    {
+                      mpDiffuserData->getNextValues()->copyPlane(itGroup->second[i], *mpDiffuserData->getLocalValues());
+                    }
+
+              // Cells of the next values outside the updated region are stale, they are
+              // never read before the next synchronization overwrites the ghost ring.
+              mpDiffuserData->flipLocalValues();
+              ++Flips;
             }
         }
+
+      // The groups which finished in the block are final after its synchronization.
+      for (itGroup = groups.begin(); itGroup != endGroup && itGroup->first <= s; ++itGroup)
+        if (FinalFlips.find(itGroup->first) == FinalFlips.end())
+          FinalFlips[itGroup->first] = Flips;
+
+      mpDiffuserData->setExchangedPlanes(Planes.size() < mCytokines.size() ? Planes : std::vector< size_t >());
+      mpCompartment->startSynchronizeDiffuser(false);
+
+      // The last synchronization is finished before returning since the caller relies on the ghost ring.
+      if (mOverlap && s < Steps)
+        {
+          Pending = true;
+        }
+      else
+        {
+          Waits.push_back(mpCompartment->finishSynchronizeDiffuser());
+        }
+
+      // mpDiffuserData->write(LocalFile::instance(mpCompartment->getName())->stream(), "\t", mpCompartment);
+    }
+
+  if (mOverlap &&
+      !Waits.empty())
+    {
+      double Total = 0.0;
+
+      for (size_t i = 0; i < Waits.size(); ++i)
+        {
+          Total += Waits[i];
+        }
+
+      LocalFile::debug() << mpCompartment->getName() << ": halo wait per substep: " << Total / Waits.size()
+                         << " s, max: " << *std::max_element(Waits.begin(), Waits.end())
+                         << " s, last (not hidden): " << Waits.back() << " s, exchanges: " << Waits.size() << std::endl;
+    }
+
+  // The values are returned in the buffer holding the planes which were not integrated, i.e., the
+  // current values before the integration, unless all planes were integrated.
+  size_t Integrated = 0;
+
+  for (itGroup = groups.begin(); itGroup != endGroup; ++itGroup)
+    {
+      Integrated += itGroup->second.size();
     }
 
-  double weightedAvg = weightedSum / count;
-  double oldVal = getCoordValue(Coords(xCoord, yCoord, zCoord));
-  double delta = weightedAvg - oldVal;
+  const size_t Home = (Integrated == mCytokines.size()) ? Flips % 2 : 0;
 
-  return constrainByMinMax((oldVal + delta * diffusionConst) * evaporationConst);
+  for (itGroup = groups.begin(); itGroup != endGroup; ++itGroup)
+    {
+      if (FinalFlips[itGroup->first] % 2 == Home) continue;
+
+      for (size_t i = 0; i < itGroup->second.size(); ++i)
+        {
+          const size_t & k = itGroup->second[i];
+
+          if (Flips % 2 == Home)
+            {
+              mpDiffuserData->getLocalValues()->copyPlane(k, *mpDiffuserData->getNextValues());
+            }
+          else
+            {
+              mpDiffuserData->getNextValues()->copyPlane(k, *mpDiffuserData->getLocalValues());
+            }
+        }
+    }
+
+  if (Flips % 2 != Home)
+    {
+      mpDiffuserData->flipLocalValues();
+    }
 }
 
-#endif // XXXX
+void DiffuserImpl::logSkippedTiles()
+{
+  if (mEpsilon > 0.0)
+    {
+      LocalFile::debug() << mpCompartment->getName() << ": skipped tiles: " << mpSweep->getSkippedTiles()
+                         << " of " << mpSweep->getSweptTiles() << std::endl;
+    }
+
+  mpSweep->resetTiles();
+}
@@ -3,15 +3,19 @@
 
 #include "repast_hpc/Point.h"
 #include "repast_hpc/GridComponents.h" /* repast::StickyBorders  */
+#include <map>
 #include <stdexcept>
 #include <vector>
 
-#include "grid/matrix.h"
+#include "grid/ValuePlanes.h"
+#include "diffuser/ExplicitSweep.h"
+#include "diffuser/TridiagonalSolver.h"
 
 namespace ENISI {
 
 class Cytokine;
 class Compartment;
+class Multigrid;
 class SharedValueLayer;
 
 class DiffuserImpl 
@@ -19,6 +23,10 @@ class DiffuserImpl
 public:
   static const double DEFAULT_MAX, DEFAULT_MIN;
 
+  static const char* SolverNames[];
+
+  enum Solver { EXPLICIT, ADI, RKL };
+
   /**
    * Constructs this with the specified evaporation constant, diffusion
    * constant, and toroidal'ness.
@@ -38,10 +46,76 @@ public:
   void diffuse(const double & deltaT);
 
 protected:
-  void computeVals(const double & deltaT);
-  void computeVals1D(const double & deltaT);
-  void computeVals2D(const double & deltaT);
-  void computeVals3D(const double & deltaT);
+  typedef ExplicitSweep::Region Region;
+
+  /**
+   * The local shape extended by ghosts cells in each dimension.
+   */
+  Region extent(const int & ghosts) const;
+
+  /**
+   * Split the extent into the interior, whose stencils do not read the ghost ring, and the boundary strips.
+   */
+  void partition(const Region & extent, Region & interior, std::vector< Region > & boundary) const;
+
+  /**
+   * Integrate each group of planes over deltaT with explicit steps of size deltaT / steps, where steps
+   * is the key of the group. The steps of the groups share the synchronizations. Afterwards the current
+   * values hold all planes.
+   */
+  void integrate(const double & deltaT, const std::map< size_t, std::vector< size_t > > & groups);
+
+  /**
+   * Compute the next values of the extent with the given number of ghost cell layers and flip.
+   */
+  void computeVals(const double & deltaT, const int & ghosts);
+
+  /**
+   * Compute the next values of the region without flipping.
+   */
+  void computeRegion(const double & deltaT, const Region & region);
+
+  /**
+   * Time the sweep for candidate tile shapes on scratch planes and select the fastest, unless the tile
+   * size is requested in both dimensions. The first process selects the shape for all processes and the
+   * selection is reused for diffusers with the same local shape.
+   */
+  void autotuneTiles();
+
+  /**
+   * Log the number of tiles skipped since the last call, since their activity was below epsilon.
+   */
+  void logSkippedTiles();
+
+  /**
+   * Peaceman-Rachford alternating direction implicit step over deltaT, which is unconditionally stable.
+   */
+  void computeADI2D(const double & deltaT);
+  void createLineSolvers(const double & deltaT);
+  void deleteLineSolvers();
+
+  /**
+   * First order Runge-Kutta-Legendre super time stepping over deltaT, where the number of
+   * stages s is chosen such that the step is stable, i.e., s^2 + s >= deltaT * spectral radius.
+   */
+  size_t diffuseRKL(const double & deltaT);
+
+  /**
+   * Apply the exact decay exp(-deltaT * degradation) to the fields without diffusion including their ghost ring.
+   */
+  void decay(const double & deltaT);
+
+  /**
+   * Replace the values of the planes by the steady state of the reaction diffusion equation, where the
+   * source rate is the change of the values since the last tick. V-cycles are done until the global
+   * residual of each plane is reduced by the tolerance, at most mSteadyCycles.
+   */
+  void solveSteadyState(const double & deltaT, const std::vector< size_t > & planes);
+
+  /**
+   * Assure that the current values hold all planes after flips, where only mPlanes were updated.
+   */
+  void restorePlanes(const size_t & flips);
 
 private:
   Compartment * mpCompartment;
@@ -50,10 +124,47 @@ private:
 
   repast::Point< int > mShape;
 
-  DenseMatrix< std::vector< double > > * mpNewValues;
-  DenseMatrix< std::vector< double > > * mpCurrentValues;
-
+  // The current and next values are double buffered by the diffuser data, i.e.,
+  // each step writes the next values and flips the buffers.
   SharedValueLayer * mpDiffuserData;
+
+  StencilKernel::Type mKernel;
+  StencilKernel::Stencil3D mStencil3D;
+  int mThreads;
+  ExplicitSweep * mpSweep;
+  bool mFuseSteps;
+
+  // The interior of the first step after a synchronization is computed while the halo is exchanged.
+  bool mOverlap;
+
+  double mEpsilon;
+
+  Solver mSolver;
+  MPI_Comm mRowCommunicator;
+  MPI_Comm mColumnCommunicator;
+  double mLineSolverDeltaT;
+  std::vector< TridiagonalSolver * > mRowSolvers;
+  std::vector< TridiagonalSolver * > mColumnSolvers;
+  std::vector< double > mRightHandSide;
+
+  double mSpectralRadius;
+  size_t mStages;
+  ValuePlanes * mpPreviousValues;
+
+  // The planes updated by the solver steps and the stable step size of each cytokine
+  std::vector< size_t > mPlanes;
+  std::vector< double > mStableDeltaT;
+
+  // The cytokines with diffusion and the ones which only decay
+  std::vector< size_t > mDiffusing;
+  std::vector< size_t > mDecaying;
+
+  // The steady state solver of each cytokine (NULL if it is time stepped) and the values after the last tick
+  std::vector< Multigrid * > mSteadySolvers;
+  ValuePlanes * mpSteadyValues;
+  int mSteadyCycles;
+  double mSteadyTolerance;
+  size_t mTick;
 };
 
 } // namespace ENISI
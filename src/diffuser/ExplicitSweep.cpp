@@ -0,0 +1,340 @@
+/*
+ * ExplicitSweep.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ExplicitSweep.h"
+
+using namespace ENISI;
+
+namespace
+{
+/**
+ * The coefficients of an explicit step for the swept planes, i.e., new = diffusion * neighbors + center * old,
+ * where center = 1 - deltaT * (degradation + centerWeight * diffusion).
+ */
+class Coefficients
+{
+public:
+  Coefficients(const std::vector< double > & diffusion, const std::vector< double > & degradation,
+               const std::vector< size_t > & planes, const double & deltaT, const double & centerWeight):
+    mPlane(planes),
+    mDiffusion(planes.size()),
+    mCenter(planes.size())
+  {
+    for (size_t i = 0; i < planes.size(); ++i)
+      {
+        const size_t & k = planes[i];
+
+        mDiffusion[i] = deltaT * diffusion[k];
+        mCenter[i] = 1.0 - deltaT * (degradation[k] + centerWeight * diffusion[k]);
+      }
+  }
+
+  int size() const
+  {
+    return mPlane.size();
+  }
+
+  std::vector< size_t > mPlane;
+  std::vector< double > mDiffusion;
+  std::vector< double > mCenter;
+};
+
+} // namespace
+
+ExplicitSweep::ExplicitSweep(const size_t & dimensions,
+                             const StencilKernel::Type & kernel,
+                             const StencilKernel::Stencil3D & stencil,
+                             const std::vector< double > & diffusion,
+                             const std::vector< double > & degradation):
+  mDimensions(dimensions),
+  mpRow2D(StencilKernel::row2D(kernel)),
+  mpRow3D(StencilKernel::row3D(kernel, stencil)),
+  mCenterWeight(StencilKernel::centerWeight(dimensions, stencil)),
+  mDiffusion(diffusion),
+  mDegradation(degradation),
+  mThreads(1),
+  mTileX(0),
+  mTileY(0),
+  mEpsilon(0.0),
+  mTileActivity(),
+  mSkippedTiles(0),
+  mSweptTiles(0)
+{}
+
+ExplicitSweep::~ExplicitSweep()
+{}
+
+void ExplicitSweep::setThreads(const int & threads)
+{
+  mThreads = std::max(threads, 1);
+}
+
+void ExplicitSweep::setTile(const int & x, const int & y)
+{
+  mTileX = x;
+  mTileY = y;
+}
+
+const int & ExplicitSweep::getTileX() const
+{
+  return mTileX;
+}
+
+const int & ExplicitSweep::getTileY() const
+{
+  return mTileY;
+}
+
+void ExplicitSweep::setEpsilon(const double & epsilon)
+{
+  mEpsilon = std::max(epsilon, 0.0);
+}
+
+const size_t & ExplicitSweep::getSkippedTiles() const
+{
+  return mSkippedTiles;
+}
+
+const size_t & ExplicitSweep::getSweptTiles() const
+{
+  return mSweptTiles;
+}
+
+void ExplicitSweep::resetTiles()
+{
+  mSkippedTiles = 0;
+  mSweptTiles = 0;
+}
+
+void ExplicitSweep::sweep(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+                          const double & deltaT, const int & steps, const Region & region)
+{
+  switch (mDimensions)
+  {
+    case 1:
+      sweep1D(current, next, planes, deltaT, region);
+      break;
+
+    case 2:
+      sweep2D(current, next, planes, deltaT, steps, region);
+      break;
+
+    case 3:
+      sweep3D(current, next, planes, deltaT, region);
+      break;
+  }
+}
+
+void ExplicitSweep::sweep1D(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+                            const double & deltaT, const Region & region)
+{
+  const Coefficients Step(mDiffusion, mDegradation, planes, deltaT, mCenterWeight);
+  const int Cytokines = Step.size();
+  const int xmax = region.upper[0];
+
+  // In 1D the single row is partitioned among the threads. The planes are independent,
+  // i.e., a thread may continue with the next plane without waiting for the others.
+#pragma omp parallel num_threads(mThreads)
+  for (int i = 0; i < Cytokines; ++i)
+    {
+      const size_t & k = Step.mPlane[i];
+      const double & Diffusion = Step.mDiffusion[i];
+      const double & Center = Step.mCenter[i];
+
+      const double * pOldValue = current.row(k, 0);
+      double * pNewValue = next.row(k, 0);
+
+#pragma omp for schedule(static) nowait
+      for (int x = region.lower[0]; x < xmax; ++x)
+        {
+          pNewValue[x] = Diffusion * (pOldValue[x - 1] + pOldValue[x + 1]) + Center * pOldValue[x];
+        }
+    }
+}
+
+void ExplicitSweep::sweep2D(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+                            const double & deltaT, const int & steps, const Region & region)
+{
+  const Coefficients Step(mDiffusion, mDegradation, planes, deltaT, mCenterWeight);
+  const int Cytokines = Step.size();
+  const int Width = region.upper[0] - region.lower[0];
+  const int Height = region.upper[1] - region.lower[1];
+  const int TileX = (mTileX > 0 && mTileX < Width) ? mTileX : Width;
+  const int TileY = (mTileY > 0 && mTileY < Height) ? mTileY : Height;
+  const int TilesX = (Width + TileX - 1) / TileX;
+  const int Tiles = TilesX * ((Height + TileY - 1) / TileY);
+  const bool Sparse = mEpsilon > 0.0;
+  size_t Skipped = 0;
+
+  if (Sparse)
+    {
+      mTileActivity.resize(Tiles);
+    }
+
+  // Each cytokine is stored in its own plane, i.e., we sweep one plane after the other.
+  // The boundary conditions are materialized in the ghost ring by SharedValueLayer::completeBufferValues,
+  // i.e., all cells are updated by the same branch free kernel. The tiles of each plane are
+  // partitioned among the threads in contiguous blocks.
+#pragma omp parallel num_threads(mThreads) reduction(+:Skipped)
+  {
+    // Intermediate values of fused steps
+    std::vector< double > Scratch[2];
+
+    // The activity of a tile is the maximal absolute value of the swept cytokines over the region read by
+    // the sweep, i.e., the tile extended by steps cells. Secreted cytokines are added to the values
+    // and are therefore included.
+    if (Sparse)
+      {
+#pragma omp for schedule(static)
+        for (int t = 0; t < Tiles; ++t)
+          {
+            const int x0 = region.lower[0] + (t % TilesX) * TileX - steps;
+            const int y0 = region.lower[1] + (t / TilesX) * TileY - steps;
+            const int Columns = std::min(TileX, region.upper[0] - x0 - steps) + 2 * steps;
+            const int ymax = std::min(y0 + steps + TileY, region.upper[1]) + steps;
+            double Activity = 0.0;
+
+            for (int i = 0; i < Cytokines; ++i)
+              for (int y = y0; y < ymax; ++y)
+                {
+                  const double * pValue = current.row(Step.mPlane[i], y) + x0;
+
+                  for (int x = 0; x < Columns; ++x)
+                    {
+                      Activity = std::max(Activity, fabs(pValue[x]));
+                    }
+                }
+
+            mTileActivity[t] = Activity;
+
+            if (Activity < mEpsilon)
+              {
+                ++Skipped;
+              }
+          }
+      }
+
+    // The planes are independent, i.e., a thread continues with the next plane without waiting.
+    for (int i = 0; i < Cytokines; ++i)
+      {
+        const size_t & k = Step.mPlane[i];
+        const double & Diffusion = Step.mDiffusion[i];
+        const double & Center = Step.mCenter[i];
+        const double Decay = Sparse ? exp(-steps * deltaT * mDegradation[k]) : 1.0;
+
+#pragma omp for schedule(static) nowait
+        for (int t = 0; t < Tiles; ++t)
+          {
+            const int x0 = region.lower[0] + (t % TilesX) * TileX;
+            const int y0 = region.lower[1] + (t / TilesX) * TileY;
+            const int Columns = std::min(TileX, region.upper[0] - x0);
+            const int ymax = std::min(y0 + TileY, region.upper[1]);
+
+            if (Sparse &&
+                mTileActivity[t] < mEpsilon)
+              {
+                // The values of a quiescent tile decay exactly over the steps but do not diffuse.
+                for (int y = y0; y < ymax; ++y)
+                  {
+                    const double * pValue = current.row(k, y) + x0;
+                    double * pNew = next.row(k, y) + x0;
+
+                    for (int x = 0; x < Columns; ++x)
+                      {
+                        pNew[x] = Decay * pValue[x];
+                      }
+                  }
+
+                continue;
+              }
+
+            if (steps == 1)
+              {
+                for (int y = y0; y < ymax; ++y)
+                  {
+                    mpRow2D(current.row(k, y - 1) + x0, current.row(k, y) + x0, current.row(k, y + 1) + x0,
+                            next.row(k, y) + x0, Columns, Diffusion, Center);
+                  }
+
+                continue;
+              }
+
+            // The tile extended by steps cells is copied to the scratch buffer. Each step shrinks the
+            // valid region by one cell and the last step writes the tile to the next values.
+            const int Stride = Columns + 2 * steps;
+            const int Rows = ymax - y0 + 2 * steps;
+            const ptrdiff_t Origin = steps * Stride + steps;
+
+            Scratch[0].resize(Stride * Rows);
+            Scratch[1].resize(Stride * Rows);
+
+            for (int r = 0; r < Rows; ++r)
+              {
+                memcpy(&Scratch[0][r * Stride], current.row(k, y0 - steps + r) + x0 - steps, Stride * sizeof(double));
+              }
+
+            for (int s = 1; s <= steps; ++s)
+              {
+                const int Extent = steps - s;
+                const double * pSource = &Scratch[(s - 1) % 2][Origin];
+                double * pTarget = &Scratch[s % 2][Origin];
+
+                for (int y = y0 - Extent; y < ymax + Extent; ++y)
+                  {
+                    const double * pCenter = pSource + (y - y0) * Stride - Extent;
+                    double * pNew = (s < steps) ? pTarget + (y - y0) * Stride - Extent : next.row(k, y) + x0;
+
+                    mpRow2D(pCenter - Stride, pCenter, pCenter + Stride, pNew, Columns + 2 * Extent, Diffusion, Center);
+                  }
+              }
+          }
+      }
+  }
+
+  mSkippedTiles += Skipped;
+  mSweptTiles += Tiles;
+}
+
+void ExplicitSweep::sweep3D(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+                            const double & deltaT, const Region & region)
+{
+  const Coefficients Step(mDiffusion, mDegradation, planes, deltaT, mCenterWeight);
+  const int Cytokines = Step.size();
+  const int Count = region.upper[0] - region.lower[0];
+  const int Rows = region.upper[1] - region.lower[1];
+  const int Rows3D = Rows * (region.upper[2] - region.lower[2]);
+
+  // The rows (y, z) of each plane are partitioned among the threads. Each row is updated from
+  // the 3 x 3 rows surrounding it, which are streamed along x. The planes are independent.
+#pragma omp parallel num_threads(mThreads)
+  for (int i = 0; i < Cytokines; ++i)
+    {
+      const size_t & k = Step.mPlane[i];
+      const double & Diffusion = Step.mDiffusion[i];
+      const double & Center = Step.mCenter[i];
+
+#pragma omp for schedule(static) nowait
+      for (int r = 0; r < Rows3D; ++r)
+        {
+          const int y = r % Rows + region.lower[1];
+          const int z = r / Rows + region.lower[2];
+          const double * pRows[9];
+
+          for (int dz = -1; dz <= 1; ++dz)
+            for (int dy = -1; dy <= 1; ++dy)
+              {
+                pRows[3 * (dz + 1) + dy + 1] = current.row(k, y + dy, z + dz) + region.lower[0];
+              }
+
+          mpRow3D(pRows, next.row(k, y, z) + region.lower[0], Count, Diffusion, Center);
+        }
+    }
+}
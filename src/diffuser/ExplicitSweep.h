@@ -0,0 +1,123 @@
+/*
+ * ExplicitSweep.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+#ifndef DIFFUSER_EXPLICITSWEEP_H_
+#define DIFFUSER_EXPLICITSWEEP_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "grid/ValuePlanes.h"
+#include "diffuser/StencilKernel.h"
+
+namespace ENISI
+{
+
+/**
+ * The explicit steps of the diffuser, i.e., new = diffusion * neighbors + center * old for the
+ * 3 point stencil in 1D and the stencils of StencilKernel in 2D and 3D. The boundary conditions must be
+ * materialized in the ghost ring of the current values.
+ *
+ * Each cytokine is stored in its own plane and the planes are swept one after the other. All kernels
+ * produce bitwise identical results (see test.cpp).
+ */
+class ExplicitSweep
+{
+private:
+  ExplicitSweep();
+  ExplicitSweep(const ExplicitSweep & src);
+
+public:
+  /**
+   * A box of cells [lower, upper) of the local values, where cells outside the shape are ghost cells.
+   * Dimensions beyond the dimension count span [0, 1).
+   */
+  struct Region
+  {
+    int lower[3];
+    int upper[3];
+  };
+
+  /**
+   * @param const size_t & dimensions (1, 2, or 3)
+   * @param const StencilKernel::Type & kernel
+   * @param const StencilKernel::Stencil3D & stencil (3D only)
+   * @param const std::vector< double > & diffusion (of each plane)
+   * @param const std::vector< double > & degradation (of each plane)
+   */
+  ExplicitSweep(const size_t & dimensions,
+                const StencilKernel::Type & kernel,
+                const StencilKernel::Stencil3D & stencil,
+                const std::vector< double > & diffusion,
+                const std::vector< double > & degradation);
+
+  ~ExplicitSweep();
+
+  /**
+   * The rows (1D: the cells) of each plane are partitioned among the threads. Each cell is computed
+   * by exactly the same operations, i.e., the results do not depend on the thread count.
+   */
+  void setThreads(const int & threads);
+
+  /**
+   * The tile size of the 2D sweep, where 0 spans the whole extent.
+   */
+  void setTile(const int & x, const int & y);
+  const int & getTileX() const;
+  const int & getTileY() const;
+
+  /**
+   * If epsilon is positive, 2D tiles whose activity is below epsilon are not diffused but only decay
+   * by exp(-steps * deltaT * degradation).
+   */
+  void setEpsilon(const double & epsilon);
+
+  /**
+   * Do steps explicit steps of size deltaT for the planes from current to next. The current values must
+   * be valid in the region extended by steps cells and the next values are valid in the region. Multiple
+   * steps are done tile by tile and are only supported in 2D. For multiple steps the intermediate values
+   * of each tile are kept in a scratch buffer and the tiles overlap by the redundantly computed cells.
+   */
+  void sweep(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+             const double & deltaT, const int & steps, const Region & region);
+
+  /**
+   * The tiles skipped since their activity was below epsilon and all swept tiles since the last reset.
+   */
+  const size_t & getSkippedTiles() const;
+  const size_t & getSweptTiles() const;
+  void resetTiles();
+
+private:
+  void sweep1D(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+               const double & deltaT, const Region & region);
+  void sweep2D(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+               const double & deltaT, const int & steps, const Region & region);
+  void sweep3D(const ValuePlanes & current, ValuePlanes & next, const std::vector< size_t > & planes,
+               const double & deltaT, const Region & region);
+
+  size_t mDimensions;
+  StencilKernel::Row2D mpRow2D;
+  StencilKernel::Row3D mpRow3D;
+  double mCenterWeight;
+  std::vector< double > mDiffusion;
+  std::vector< double > mDegradation;
+  int mThreads;
+
+  // A tile size of 0 spans the whole extent.
+  int mTileX;
+  int mTileY;
+
+  double mEpsilon;
+  std::vector< double > mTileActivity;
+  size_t mSkippedTiles;
+  size_t mSweptTiles;
+};
+
+} /* namespace ENISI */
+
+#endif /* DIFFUSER_EXPLICITSWEEP_H_ */
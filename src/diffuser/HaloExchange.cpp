@@ -0,0 +1,546 @@
+/*
+ * HaloExchange.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "HaloExchange.h"
+
+#include "DataWriter/LocalFile.h"
+#include "grid/Properties.h"
+
+using namespace ENISI;
+
+// static
+const char* HaloExchange::MethodNames[] = {"repast", "MPI", NULL};
+
+// static
+HaloExchange::Method HaloExchange::method()
+{
+  // All processes read the same run properties, i.e., they agree on the method. The direct exchange
+  // must be requested.
+  static Method ExchangeMethod =
+    Properties::toEnum(Properties::instance(Properties::run)->getValue("diffuser.exchange"), MethodNames, REPAST);
+
+  return ExchangeMethod;
+}
+
+// static
+bool HaloExchange::persistent()
+{
+  static bool Persistent = false;
+  static bool Initialized = false;
+
+  if (!Initialized)
+    {
+      Properties::instance(Properties::run)->getValue("diffuser.exchange.persistent", Persistent);
+      Initialized = true;
+    }
+
+  return Persistent;
+}
+
+// static
+bool HaloExchange::sharedMemory()
+{
+  static bool Shared = false;
+  static bool Initialized = false;
+
+  if (!Initialized)
+    {
+      Properties::instance(Properties::run)->getValue("diffuser.exchange.shared", Shared);
+      Initialized = true;
+    }
+
+  return Shared;
+}
+
+static size_t segmentSize(const SharedValueLayer::Segments & segments)
+{
+  size_t Size = 0;
+  SharedValueLayer::Segments::const_iterator it = segments.begin();
+  SharedValueLayer::Segments::const_iterator end = segments.end();
+
+  for (; it != end; ++it)
+    {
+      Size += it->second;
+    }
+
+  return Size;
+}
+
+static void packSegments(const double * pValues, const SharedValueLayer::Segments & segments,
+                         std::vector< double > & packed)
+{
+  packed.resize(segmentSize(segments));
+
+  std::vector< double >::iterator itPacked = packed.begin();
+  SharedValueLayer::Segments::const_iterator it = segments.begin();
+  SharedValueLayer::Segments::const_iterator end = segments.end();
+
+  for (; it != end; ++it)
+    {
+      itPacked = std::copy(pValues + it->first, pValues + it->first + it->second, itPacked);
+    }
+}
+
+static void unpackSegments(const std::vector< double > & packed, const SharedValueLayer::Segments & segments,
+                           SharedValueLayer::BufferValues & values)
+{
+  std::vector< double >::const_iterator itPacked = packed.begin();
+  SharedValueLayer::Segments::const_iterator it = segments.begin();
+  SharedValueLayer::Segments::const_iterator end = segments.end();
+
+  for (; it != end; ++it)
+    {
+      std::copy(itPacked, itPacked + it->second, values.begin() + it->first);
+      itPacked += it->second;
+    }
+}
+
+HaloExchange::HaloExchange(MPI_Comm communicator, const int & tag, SharedValueLayer * pLocal,
+                           const std::vector< int > & targets,
+                           const std::vector< SharedValueLayer * > & sources,
+                           const std::vector< int > & sourceRanks,
+                           const Borders & globalBorders):
+  mCommunicator(communicator),
+  mTag(tag),
+  mpLocal(pLocal),
+  mTargets(targets),
+  mSources(sources),
+  mSourceRanks(sourceRanks),
+  mTargetCells(targets.size()),
+  mSourceCells(sources.size()),
+  mPersistent(persistent()),
+  mLayouts(),
+  mpLayout(NULL),
+  mShared(false),
+  mNodeCommunicator(MPI_COMM_NULL),
+  mWindow(MPI_WIN_NULL),
+  mpFrames(NULL),
+  mFrameSize(0),
+  mSharedTargets(targets.size(), false),
+  mSourceFrames(sources.size(), NULL),
+  mExchanges(0),
+  mSend(),
+  mSendSecretions(),
+  mReceiveSecretions(),
+  mSecretionRequests(),
+  mSecretions(false)
+{
+  // Each source is told which of its cells provide our ghost cells as rectangles (x, y, width, height).
+  std::vector< std::vector< int > > Requested(mSources.size());
+  std::vector< MPI_Request > Requests(mSources.size());
+
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      mpLocal->ghostSources(mSources[i]->origin(), globalBorders, mSourceCells[i]);
+
+      std::vector< SharedValueLayer::Rectangle >::const_iterator it = mSourceCells[i].begin();
+      std::vector< SharedValueLayer::Rectangle >::const_iterator end = mSourceCells[i].end();
+
+      for (; it != end; ++it)
+        {
+          Requested[i].push_back(it->x);
+          Requested[i].push_back(it->y);
+          Requested[i].push_back(it->width);
+          Requested[i].push_back(it->height);
+        }
+
+      MPI_Isend(Requested[i].empty() ? NULL : &Requested[i][0], Requested[i].size(), MPI_INT, mSourceRanks[i], mTag,
+                mCommunicator, &Requests[i]);
+    }
+
+  for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+      MPI_Status Status;
+      int Count = 0;
+
+      MPI_Probe(mTargets[i], mTag, mCommunicator, &Status);
+      MPI_Get_count(&Status, MPI_INT, &Count);
+
+      std::vector< int > Cells(Count);
+      MPI_Recv(Count > 0 ? &Cells[0] : NULL, Count, MPI_INT, mTargets[i], mTag, mCommunicator, MPI_STATUS_IGNORE);
+
+      for (int j = 0; j + 3 < Count; j += 4)
+        {
+          SharedValueLayer::Rectangle Rectangle = {Cells[j], Cells[j + 1], Cells[j + 2], Cells[j + 3]};
+          mTargetCells[i].push_back(Rectangle);
+        }
+    }
+
+  MPI_Waitall(Requests.size(), Requests.empty() ? NULL : &Requests[0], MPI_STATUSES_IGNORE);
+
+  // The sent values compared to sending the whole frame to each target
+  repast::Point< int > Origin(0, 0);
+  mpLocal->getBufferValues(Origin, mSend);
+
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      mSources[i]->resizeBufferValues(mpLocal->getExchangedPlanes());
+    }
+
+  if (sharedMemory())
+    {
+      createWindow();
+    }
+
+  const Layout & Initial = layout();
+  size_t Sent = 0;
+  size_t Shared = 0;
+
+  for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+      if (mSharedTargets[i])
+        {
+          Shared += segmentSize(Initial.targetSegments[i]);
+        }
+      else
+        {
+          Sent += segmentSize(Initial.targetSegments[i]);
+        }
+    }
+
+  LocalFile::debug() << "halo exchange: sent values: " << Sent << ", shared values: " << Shared << " of "
+                     << mSend.size() * mTargets.size() << (mPersistent ? " (persistent)" : "") << std::endl;
+}
+
+HaloExchange::~HaloExchange()
+{
+  if (mPersistent)
+    {
+      // The persistent requests are inactive after each finish.
+      std::map< size_t, Layout >::iterator it = mLayouts.begin();
+      std::map< size_t, Layout >::iterator end = mLayouts.end();
+
+      for (; it != end; ++it)
+        for (size_t i = 0; i < it->second.requests.size(); ++i)
+          {
+            MPI_Request_free(&it->second.requests[i]);
+          }
+    }
+
+  // All processes of the communicator delete their compartments in the same order, i.e., the window
+  // is freed collectively.
+  if (mShared)
+    {
+      MPI_Win_unlock_all(mWindow);
+      MPI_Win_free(&mWindow);
+      MPI_Comm_free(&mNodeCommunicator);
+    }
+}
+
+void HaloExchange::createWindow()
+{
+  // MPI_Comm_split_type and MPI_Win_allocate_shared are collective over the whole communicator. All
+  // processes create the exchange of each compartment in the same order, which requires that each process
+  // holds local diffuser values. The frame of all planes is the largest, which are exchanged during the
+  // initialization.
+  MPI_Comm_split_type(mCommunicator, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &mNodeCommunicator);
+
+  mShared = true;
+  mFrameSize = mSend.size();
+
+  // The frame is double buffered, i.e., the frame of an exchange is read by the targets while we
+  // write the next one.
+  MPI_Win_allocate_shared(2 * mFrameSize * sizeof(double), sizeof(double), MPI_INFO_NULL, mNodeCommunicator,
+                          &mpFrames, &mWindow);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, mWindow);
+
+  MPI_Group Group;
+  MPI_Group NodeGroup;
+  MPI_Comm_group(mCommunicator, &Group);
+  MPI_Comm_group(mNodeCommunicator, &NodeGroup);
+
+  // A neighbor on the node uses the window only if it is both target and source. The exchange of its
+  // values tells us that it finished reading our previous frame before we overwrite it.
+  for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+      int NodeRank = MPI_UNDEFINED;
+      MPI_Group_translate_ranks(Group, 1, &mTargets[i], NodeGroup, &NodeRank);
+
+      mSharedTargets[i] = NodeRank != MPI_UNDEFINED &&
+                          std::find(mSourceRanks.begin(), mSourceRanks.end(), mTargets[i]) != mSourceRanks.end();
+    }
+
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      int NodeRank = MPI_UNDEFINED;
+      MPI_Group_translate_ranks(Group, 1, &mSourceRanks[i], NodeGroup, &NodeRank);
+
+      if (NodeRank == MPI_UNDEFINED ||
+          std::find(mTargets.begin(), mTargets.end(), mSourceRanks[i]) == mTargets.end())
+        {
+          continue;
+        }
+
+      MPI_Aint Size = 0;
+      int DisplacementUnit = 0;
+      double * pFrames = NULL;
+
+      MPI_Win_shared_query(mWindow, NodeRank, &Size, &DisplacementUnit, &pFrames);
+      mSourceFrames[i] = pFrames;
+    }
+
+  MPI_Group_free(&Group);
+  MPI_Group_free(&NodeGroup);
+}
+
+void HaloExchange::exchange(const bool & secretions)
+{
+  start(secretions);
+  finish();
+}
+
+void HaloExchange::start(const bool & secretions)
+{
+  // Secretions which are not sent would only be applied to our values but not to the copies of the targets.
+  if (!secretions &&
+      !mpLocal->getSecretions().empty())
+    {
+      throw std::runtime_error("HaloExchange: pending secretions must be exchanged.");
+    }
+
+  mSecretions = secretions;
+
+  const std::vector< size_t > & Planes = mpLocal->getExchangedPlanes();
+
+  const double * pFrame = NULL;
+
+  if (mShared)
+    {
+      // The targets on the node read the frame after receiving the empty message of the halo.
+      double * pShared = mpFrames + (mExchanges % 2) * mFrameSize;
+      mpLocal->copyBufferValues(pShared);
+      MPI_Win_sync(mWindow);
+      pFrame = pShared;
+    }
+  else
+    {
+      repast::Point< int > Origin(0, 0);
+      mpLocal->getBufferValues(Origin, mSend);
+      pFrame = mSend.empty() ? NULL : &mSend[0];
+    }
+
+  // The sources hold the same planes, i.e., the layout of their buffer values is known before receiving.
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      mSources[i]->resizeBufferValues(Planes);
+    }
+
+  mpLayout = &layout();
+
+  for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+      if (mSharedTargets[i]) continue;
+
+      packSegments(pFrame, mpLayout->targetSegments[i], mpLayout->send[i]);
+    }
+
+  if (mPersistent)
+    {
+      // The receives precede the sends in the requests, i.e., they are started first.
+      if (!mpLayout->requests.empty())
+        {
+          MPI_Startall(mpLayout->requests.size(), &mpLayout->requests[0]);
+        }
+    }
+  else
+    {
+      postRequests(*mpLayout);
+    }
+
+  if (!mSecretions) return;
+
+  packSecretions(mpLocal->getSecretions(), mSendSecretions);
+
+  double * pSecretions = mSendSecretions.empty() ? NULL : &mSendSecretions[0];
+  mSecretionRequests.resize(mTargets.size());
+
+  for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+      MPI_Isend(pSecretions, mSendSecretions.size(), MPI_DOUBLE, mTargets[i], mTag + 1, mCommunicator, &mSecretionRequests[i]);
+    }
+}
+
+void HaloExchange::finish()
+{
+  const std::vector< size_t > & Planes = mpLocal->getExchangedPlanes();
+
+  std::vector< MPI_Request > & Requests = mpLayout->requests;
+
+  if (mSecretions)
+    {
+      receiveSecretions();
+      MPI_Waitall(mSecretionRequests.size(), mSecretionRequests.empty() ? NULL : &mSecretionRequests[0], MPI_STATUSES_IGNORE);
+    }
+
+  MPI_Waitall(Requests.size(), Requests.empty() ? NULL : &Requests[0], MPI_STATUSES_IGNORE);
+
+  if (mShared)
+    {
+      MPI_Win_sync(mWindow);
+    }
+
+  // Only the cells providing our ghost cells are updated in the buffer values of the sources.
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      SharedValueLayer::BufferValues & Values = mSources[i]->resizeBufferValues(Planes);
+
+      if (mSourceFrames[i] != NULL)
+        {
+          const double * pFrame = mSourceFrames[i] + (mExchanges % 2) * mFrameSize;
+          SharedValueLayer::Segments::const_iterator it = mpLayout->sourceSegments[i].begin();
+          SharedValueLayer::Segments::const_iterator end = mpLayout->sourceSegments[i].end();
+
+          for (; it != end; ++it)
+            {
+              std::copy(pFrame + it->first, pFrame + it->first + it->second, Values.begin() + it->first);
+            }
+        }
+      else
+        {
+          unpackSegments(mpLayout->receive[i], mpLayout->sourceSegments[i], Values);
+        }
+    }
+
+  ++mExchanges;
+}
+
+HaloExchange::Layout & HaloExchange::layout()
+{
+  // An empty selection of planes exchanges all planes, i.e., the count determines the layout.
+  const size_t Planes = mpLocal->getExchangedPlanes().size();
+  std::map< size_t, Layout >::iterator found = mLayouts.find(Planes);
+
+  if (found != mLayouts.end())
+    {
+      return found->second;
+    }
+
+  Layout & New = mLayouts[Planes];
+
+  New.targetSegments.resize(mTargets.size());
+  New.sourceSegments.resize(mSources.size());
+  New.send.resize(mTargets.size());
+  New.receive.resize(mSources.size());
+
+  // The buffers are sized once as the segments are fixed for the count of planes.
+  for (size_t i = 0; i < mTargets.size(); ++i)
+    {
+      mpLocal->bufferSegments(mTargetCells[i], New.targetSegments[i]);
+
+      // The messages to the targets on the node are empty as they read our frame.
+      New.send[i].resize(mSharedTargets[i] ? 0 : segmentSize(New.targetSegments[i]));
+    }
+
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      mSources[i]->bufferSegments(mSourceCells[i], New.sourceSegments[i]);
+
+      New.receive[i].resize((mSourceFrames[i] != NULL) ? 0 : segmentSize(New.sourceSegments[i]));
+    }
+
+  New.requests.resize(mSources.size() + mTargets.size(), MPI_REQUEST_NULL);
+
+  if (!mPersistent) return New;
+
+  // The matching and setup of the messages is done once for the count of planes.
+  std::vector< MPI_Request >::iterator itRequest = New.requests.begin();
+
+  for (size_t i = 0; i < mSources.size(); ++i, ++itRequest)
+    {
+      MPI_Recv_init(New.receive[i].empty() ? NULL : &New.receive[i][0], New.receive[i].size(), MPI_DOUBLE,
+                    mSourceRanks[i], mTag, mCommunicator, &*itRequest);
+    }
+
+  for (size_t i = 0; i < mTargets.size(); ++i, ++itRequest)
+    {
+      MPI_Send_init(New.send[i].empty() ? NULL : &New.send[i][0], New.send[i].size(), MPI_DOUBLE,
+                    mTargets[i], mTag, mCommunicator, &*itRequest);
+    }
+
+  return New;
+}
+
+void HaloExchange::postRequests(Layout & layout)
+{
+  std::vector< MPI_Request >::iterator itRequest = layout.requests.begin();
+
+  // The receives are posted first.
+  for (size_t i = 0; i < mSources.size(); ++i, ++itRequest)
+    {
+      MPI_Irecv(layout.receive[i].empty() ? NULL : &layout.receive[i][0], layout.receive[i].size(), MPI_DOUBLE,
+                mSourceRanks[i], mTag, mCommunicator, &*itRequest);
+    }
+
+  for (size_t i = 0; i < mTargets.size(); ++i, ++itRequest)
+    {
+      MPI_Isend(layout.send[i].empty() ? NULL : &layout.send[i][0], layout.send[i].size(), MPI_DOUBLE,
+                mTargets[i], mTag, mCommunicator, &*itRequest);
+    }
+}
+
+void HaloExchange::receiveSecretions()
+{
+  for (size_t i = 0; i < mSources.size(); ++i)
+    {
+      MPI_Status Status;
+      int Count = 0;
+
+      MPI_Probe(mSourceRanks[i], mTag + 1, mCommunicator, &Status);
+      MPI_Get_count(&Status, MPI_DOUBLE, &Count);
+
+      mReceiveSecretions.resize(Count);
+      MPI_Recv(Count > 0 ? &mReceiveSecretions[0] : NULL, Count, MPI_DOUBLE, mSourceRanks[i], mTag + 1, mCommunicator, MPI_STATUS_IGNORE);
+
+      SharedValueLayer::Secretions Secretions;
+      unpackSecretions(mReceiveSecretions, Secretions);
+      mSources[i]->setSecretions(Secretions);
+    }
+}
+
+// static
+void HaloExchange::packSecretions(const SharedValueLayer::Secretions & secretions, std::vector< double > & packed)
+{
+  packed.clear();
+
+  if (secretions.empty()) return;
+
+  // The header holds the size of the keys and the values, which are the same for all cells.
+  SharedValueLayer::Secretions::const_iterator it = secretions.begin();
+  SharedValueLayer::Secretions::const_iterator end = secretions.end();
+
+  packed.push_back(it->first.size());
+  packed.push_back(it->second.size());
+  packed.reserve(2 + secretions.size() * (it->first.size() + it->second.size()));
+
+  for (; it != end; ++it)
+    {
+      packed.insert(packed.end(), it->first.begin(), it->first.end());
+      packed.insert(packed.end(), it->second.begin(), it->second.end());
+    }
+}
+
+// static
+void HaloExchange::unpackSecretions(const std::vector< double > & packed, SharedValueLayer::Secretions & secretions)
+{
+  secretions.clear();
+
+  if (packed.size() < 2) return;
+
+  const size_t KeySize = packed[0];
+  const size_t ValueSize = packed[1];
+  std::vector< double >::const_iterator it = packed.begin() + 2;
+  std::vector< double >::const_iterator end = packed.end();
+
+  for (; it + KeySize + ValueSize <= end; it += KeySize + ValueSize)
+    {
+      std::vector< int > Key(it, it + KeySize);
+      secretions[Key].assign(it + KeySize, it + KeySize + ValueSize);
+    }
+}
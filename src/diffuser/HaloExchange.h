@@ -0,0 +1,172 @@
+/*
+ * HaloExchange.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#ifndef DIFFUSER_HALOEXCHANGE_H_
+#define DIFFUSER_HALOEXCHANGE_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include <mpi.h>
+
+#include "agent/SharedValueLayer.h"
+
+namespace ENISI
+{
+
+/**
+ * Direct exchange of the diffuser buffer values and secretions with the neighboring processes, which
+ * replaces the synchronization of the diffuser values as Repast agents. The neighbors are the processes
+ * holding a copy of our diffuser values (targets) and the processes whose diffuser values we hold
+ * (sources), i.e., the copies must have been created by a Repast synchronization before.
+ *
+ * Each neighbor receives only the cells of the buffer values which provide its ghost cells, e.g., the
+ * north neighbor receives the north rows and a diagonal neighbor the corner. The receivers determine
+ * these cells when the exchange is created and send them to the sources. Both sides derive the same
+ * segments of the buffer values, whose layout is known to all processes, i.e., the values are sent
+ * without any description. As the neighbors never change, the halo messages of each count of exchanged
+ * planes may use persistent requests, which are set up on first use and restarted by each exchange.
+ * The secretions are of variable size and received after probing. They are only exchanged on request,
+ * i.e., by the synchronization at the start of the tick, which is the only one with pending secretions.
+ *
+ * Neighbors on the same node may instead read the cells from our buffer values, which are written to an
+ * MPI-3 shared memory window. The halo message is then empty and only signals that the frame is ready.
+ * The window holds only this frame, the cytokine fields stay in the private memory of each process.
+ */
+class HaloExchange
+{
+private:
+  HaloExchange();
+  HaloExchange(const HaloExchange & src);
+
+public:
+  static const char* MethodNames[];
+
+  enum Method { REPAST, DIRECT };
+
+  /**
+   * The method of the diffuser synchronization (run.props: diffuser.exchange = repast | MPI)
+   */
+  static Method method();
+
+  /**
+   * Whether the halo messages use persistent requests (run.props: diffuser.exchange.persistent)
+   */
+  static bool persistent();
+
+  /**
+   * Whether neighbors on the same node read the halo from a shared memory window instead of receiving
+   * messages (run.props: diffuser.exchange.shared)
+   */
+  static bool sharedMemory();
+
+  /**
+   * The tags tag and tag + 1 must not be used by any other communication on the communicator.
+   * The constructor and the destructor are collective over the whole communicator, i.e., every process
+   * must create and delete the exchange of each compartment in the same order, even one without
+   * neighbors. With shared memory the node communicator and the window are created and freed there.
+   * @param MPI_Comm communicator
+   * @param const int & tag
+   * @param SharedValueLayer * pLocal
+   * @param const std::vector< int > & targets (ranks holding a copy of the local values)
+   * @param const std::vector< SharedValueLayer * > & sources (local copies of the neighbors' values)
+   * @param const std::vector< int > & sourceRanks
+   * @param const Borders & globalBorders
+   */
+  HaloExchange(MPI_Comm communicator, const int & tag, SharedValueLayer * pLocal,
+               const std::vector< int > & targets,
+               const std::vector< SharedValueLayer * > & sources,
+               const std::vector< int > & sourceRanks,
+               const Borders & globalBorders);
+
+  /**
+   * Collective over the whole communicator, see the constructor.
+   */
+  ~HaloExchange();
+
+  /**
+   * Send the buffer values and, if requested, the secretions of the local values to the targets and
+   * receive those of the sources. The exchanged planes of the local values and the request of the
+   * secretions apply to all processes. Without secretions the local values must have none pending.
+   */
+  void exchange(const bool & secretions);
+
+  /**
+   * The exchange split into posting the messages and completing them, which allows to compute while
+   * the messages are in flight. The local values must not change in between.
+   */
+  void start(const bool & secretions);
+  void finish();
+
+private:
+  static void packSecretions(const SharedValueLayer::Secretions & secretions, std::vector< double > & packed);
+  static void unpackSecretions(const std::vector< double > & packed, SharedValueLayer::Secretions & secretions);
+
+  /**
+   * The segments and message buffers of the halo for a count of exchanged planes. The requests are
+   * the receives from the sources followed by the sends to the targets. Persistent requests are bound
+   * to the buffers, i.e., the buffers must not be reallocated.
+   */
+  struct Layout
+  {
+    std::vector< SharedValueLayer::Segments > targetSegments;
+    std::vector< SharedValueLayer::Segments > sourceSegments;
+    std::vector< std::vector< double > > send;
+    std::vector< std::vector< double > > receive;
+    std::vector< MPI_Request > requests;
+  };
+
+  void receiveSecretions();
+
+  /**
+   * Select the layout for the current count of exchanged planes, which is created on first use.
+   */
+  Layout & layout();
+  void postRequests(Layout & layout);
+
+  /**
+   * Allocate the shared memory window of the node and locate the frames of the sources on the node.
+   */
+  void createWindow();
+
+  MPI_Comm mCommunicator;
+  int mTag;
+  SharedValueLayer * mpLocal;
+  std::vector< int > mTargets;
+  std::vector< SharedValueLayer * > mSources;
+  std::vector< int > mSourceRanks;
+
+  // The cells of our local grid needed by each target and the cells of each source needed by us
+  std::vector< std::vector< SharedValueLayer::Rectangle > > mTargetCells;
+  std::vector< std::vector< SharedValueLayer::Rectangle > > mSourceCells;
+
+  bool mPersistent;
+  std::map< size_t, Layout > mLayouts;
+  Layout * mpLayout;
+
+  // The double buffered frames of the buffer values in the shared memory window and the frames of the
+  // sources on the node (NULL for the others)
+  bool mShared;
+  MPI_Comm mNodeCommunicator;
+  MPI_Win mWindow;
+  double * mpFrames;
+  size_t mFrameSize;
+  std::vector< bool > mSharedTargets;
+  std::vector< double * > mSourceFrames;
+  size_t mExchanges;
+
+  SharedValueLayer::BufferValues mSend;
+  std::vector< double > mSendSecretions;
+  std::vector< double > mReceiveSecretions;
+  std::vector< MPI_Request > mSecretionRequests;
+  bool mSecretions;
+};
+
+} /* namespace ENISI */
+
+#endif /* DIFFUSER_HALOEXCHANGE_H_ */
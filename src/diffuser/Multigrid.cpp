@@ -0,0 +1,209 @@
+/*
+ * Multigrid.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Multigrid.h"
+
+using namespace ENISI;
+
+// Damping of the Jacobi sweeps and the number of sweeps per level
+static const double OMEGA = 0.8;
+static const size_t PRE_SWEEPS = 2;
+static const size_t POST_SWEEPS = 2;
+static const size_t COARSEST_SWEEPS = 32;
+
+Multigrid::Multigrid(const int & width, const int & height, const double & diffusion, const double & degradation):
+  mDegradation(degradation),
+  mLevels()
+{
+  Level Fine;
+  Fine.width = width;
+  Fine.height = height;
+  Fine.stride = width + 2;
+  Fine.diffusion = diffusion;
+
+  // The values of the finest level are provided by the caller.
+  Fine.residual.resize(Fine.stride * (height + 2), 0.0);
+  Fine.smoothed.resize(Fine.stride * (height + 2), 0.0);
+  mLevels.push_back(Fine);
+
+  while (mLevels.back().width % 2 == 0 && mLevels.back().width >= 4 &&
+         mLevels.back().height % 2 == 0 && mLevels.back().height >= 4)
+    {
+      const Level & Finer = mLevels.back();
+
+      // The diffusion in grid units scales with the inverse square of the cell size.
+      Level Coarse;
+      Coarse.width = Finer.width / 2;
+      Coarse.height = Finer.height / 2;
+      Coarse.stride = Coarse.width + 2;
+      Coarse.diffusion = 0.25 * Finer.diffusion;
+
+      size_t Size = Coarse.stride * (Coarse.height + 2);
+      Coarse.u.resize(Size, 0.0);
+      Coarse.f.resize(Size, 0.0);
+      Coarse.residual.resize(Size, 0.0);
+      Coarse.smoothed.resize(Size, 0.0);
+
+      mLevels.push_back(Coarse);
+    }
+}
+
+Multigrid::~Multigrid()
+{}
+
+size_t Multigrid::levels() const
+{
+  return mLevels.size();
+}
+
+double Multigrid::cycle(double * pU, const double * pF, const ptrdiff_t & stride)
+{
+  double Residual = residual(0, pU, pF, stride, &mLevels[0].residual[mLevels[0].stride + 1]);
+
+  vCycle(0, pU, pF, stride);
+
+  return Residual;
+}
+
+void Multigrid::vCycle(const size_t & level, double * pU, const double * pF, const ptrdiff_t & stride)
+{
+  Level & Current = mLevels[level];
+  double * pSmoothed = &Current.smoothed[Current.stride + 1];
+
+  if (level + 1 == mLevels.size())
+    {
+      smooth(level, pU, pF, stride, COARSEST_SWEEPS, pSmoothed);
+      return;
+    }
+
+  smooth(level, pU, pF, stride, PRE_SWEEPS, pSmoothed);
+
+  double * pResidual = &Current.residual[Current.stride + 1];
+  residual(level, pU, pF, stride, pResidual);
+
+  // The coarse grid correction satisfies the error equation with homogeneous boundary values.
+  Level & Coarse = mLevels[level + 1];
+  double * pCoarseU = &Coarse.u[Coarse.stride + 1];
+  double * pCoarseF = &Coarse.f[Coarse.stride + 1];
+
+  std::fill(Coarse.u.begin(), Coarse.u.end(), 0.0);
+
+  for (int y = 0; y < Coarse.height; ++y)
+    for (int x = 0; x < Coarse.width; ++x)
+      {
+        const double * pFine = pResidual + 2 * y * Current.stride + 2 * x;
+
+        pCoarseF[y * Coarse.stride + x] = 0.25 * (pFine[0] + pFine[1] + pFine[Current.stride] + pFine[Current.stride + 1]);
+      }
+
+  vCycle(level + 1, pCoarseU, pCoarseF, Coarse.stride);
+
+  // Bilinear prolongation: each fine cell is weighted 9/16, 3/16, 3/16, and 1/16 by the nearest coarse cells.
+  for (int y = 0; y < Current.height; ++y)
+    {
+      double * pValue = pU + y * stride;
+      const double * pCorrection = pCoarseU + (y / 2) * Coarse.stride;
+      const ptrdiff_t dy = (y % 2 == 0) ? -Coarse.stride : Coarse.stride;
+
+      for (int x = 0; x < Current.width; ++x)
+        {
+          const double * p = pCorrection + x / 2;
+          const ptrdiff_t dx = (x % 2 == 0) ? -1 : 1;
+
+          pValue[x] += 0.5625 * p[0] + 0.1875 * (p[dx] + p[dy]) + 0.0625 * p[dx + dy];
+        }
+    }
+
+  smooth(level, pU, pF, stride, POST_SWEEPS, pSmoothed);
+}
+
+void Multigrid::smooth(const size_t & index, double * pU, const double * pF, const ptrdiff_t & stride,
+                       const size_t & sweeps, double * pSmoothed) const
+{
+  const Level & level = mLevels[index];
+  const double Diagonal = mDegradation + 6.0 * level.diffusion;
+  const double Scale = OMEGA / Diagonal;
+
+  for (size_t s = 0; s < sweeps; ++s)
+    {
+      if (index > 0) correctionBoundary(level, pU, stride);
+
+      for (int y = 0; y < level.height; ++y)
+        {
+          const double * pValue = pU + y * stride;
+          const double * pSource = pF + y * stride;
+          double * pNew = pSmoothed + y * level.stride;
+
+          for (int x = 0; x < level.width; ++x)
+            {
+              const double * p = pValue + x;
+              const double Orthogonal = p[-1] + p[1] + p[-stride] + p[stride];
+              const double Diagonals = p[-stride - 1] + p[-stride + 1] + p[stride - 1] + p[stride + 1];
+              const double Au = Diagonal * p[0] - 0.3 * level.diffusion * (Diagonals + 4.0 * Orthogonal);
+
+              pNew[x] = p[0] + Scale * (pSource[x] - Au);
+            }
+        }
+
+      for (int y = 0; y < level.height; ++y)
+        {
+          std::copy(pSmoothed + y * level.stride, pSmoothed + y * level.stride + level.width, pU + y * stride);
+        }
+    }
+}
+
+double Multigrid::residual(const size_t & index, double * pU, const double * pF, const ptrdiff_t & stride,
+                           double * pResidual) const
+{
+  const Level & level = mLevels[index];
+
+  if (index > 0) correctionBoundary(level, pU, stride);
+
+  const double Diagonal = mDegradation + 6.0 * level.diffusion;
+  double Max = 0.0;
+
+  for (int y = 0; y < level.height; ++y)
+    {
+      const double * pValue = pU + y * stride;
+      const double * pSource = pF + y * stride;
+      double * pTarget = pResidual + y * level.stride;
+
+      for (int x = 0; x < level.width; ++x)
+        {
+          const double * p = pValue + x;
+          const double Orthogonal = p[-1] + p[1] + p[-stride] + p[stride];
+          const double Diagonals = p[-stride - 1] + p[-stride + 1] + p[stride - 1] + p[stride + 1];
+
+          pTarget[x] = pSource[x] - (Diagonal * p[0] - 0.3 * level.diffusion * (Diagonals + 4.0 * Orthogonal));
+          Max = std::max(Max, fabs(pTarget[x]));
+        }
+    }
+
+  return Max;
+}
+
+void Multigrid::correctionBoundary(const Level & level, double * pU, const ptrdiff_t & stride) const
+{
+  // The correction vanishes at the cell faces of the boundary on all levels, i.e., the ghost
+  // values are the negated adjacent interior values. Otherwise the coarse domains would grow.
+  for (int y = 0; y < level.height; ++y)
+    {
+      double * pRow = pU + y * stride;
+
+      pRow[-1] = -pRow[0];
+      pRow[level.width] = -pRow[level.width - 1];
+    }
+
+  for (int x = -1; x <= level.width; ++x)
+    {
+      pU[x - stride] = -pU[x];
+      pU[x + level.height * stride] = -pU[x + (level.height - 1) * stride];
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Multigrid.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#ifndef DIFFUSER_MULTIGRID_H_
+#define DIFFUSER_MULTIGRID_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace ENISI
+{
+
+/**
+ * Geometric multigrid for the steady state of the reaction diffusion equation on a local 2D grid
+ *   (degradation + 6 * diffusion) u - 0.3 * diffusion * (sum of diagonal + 4 * sum of orthogonal neighbors) = f,
+ * i.e., the weighted 9 point stencil of the explicit diffuser. The ghost ring (width 1) of u holds fixed
+ * boundary values, which are provided by the synchronization of the diffuser data.
+ *
+ * The grid is cell centered: the coarse cells cover 2 x 2 fine cells, the residual is restricted by
+ * averaging and the correction is prolongated bilinearly. The correction vanishes at the boundary
+ * faces on all coarse levels. Coarsening stops when an extent is odd or smaller than 4. Each level
+ * is smoothed by damped Jacobi sweeps.
+ */
+class Multigrid
+{
+private:
+  Multigrid();
+  Multigrid(const Multigrid & src);
+
+public:
+  /**
+   * @param const int & width (interior extent in x)
+   * @param const int & height (interior extent in y)
+   * @param const double & diffusion
+   * @param const double & degradation
+   */
+  Multigrid(const int & width, const int & height, const double & diffusion, const double & degradation);
+
+  ~Multigrid();
+
+  /**
+   * Do one V-cycle in place. The cell (x, y) of u and f is located at pU[x + y * stride] and pF[x + y * stride].
+   * @param double * pU
+   * @param const double * pF
+   * @param const ptrdiff_t & stride
+   * @return double residual (maximum norm before the cycle)
+   */
+  double cycle(double * pU, const double * pF, const ptrdiff_t & stride);
+
+  size_t levels() const;
+
+private:
+  struct Level
+  {
+    int width;
+    int height;
+    ptrdiff_t stride;
+    double diffusion;
+
+    // Storage including the ghost ring of width 1, the first interior cell is at stride + 1.
+    std::vector< double > u;
+    std::vector< double > f;
+    std::vector< double > residual;
+    std::vector< double > smoothed;
+  };
+
+  void vCycle(const size_t & level, double * pU, const double * pF, const ptrdiff_t & stride);
+  void smooth(const size_t & level, double * pU, const double * pF, const ptrdiff_t & stride,
+              const size_t & sweeps, double * pSmoothed) const;
+  double residual(const size_t & level, double * pU, const double * pF, const ptrdiff_t & stride,
+                  double * pResidual) const;
+  void correctionBoundary(const Level & level, double * pU, const ptrdiff_t & stride) const;
+
+  double mDegradation;
+  std::vector< Level > mLevels;
+};
+
+} /* namespace ENISI */
+
+#endif /* DIFFUSER_MULTIGRID_H_ */
@@ -0,0 +1,506 @@
+/*
+ * StencilKernel.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#include <cstddef>
+
+#include "StencilKernel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define ENISI_X86_KERNELS
+# include <immintrin.h>
+#endif
+
+using namespace ENISI;
+
+// static
+const char* StencilKernel::TypeNames[] = {"auto", "scalar", "SSE2", "AVX2", "AVX512", NULL};
+
+// static
+const char* StencilKernel::Stencil3DNames[] = {"7", "27", NULL};
+
+static void scalarRow2D(const double * pNorth, const double * pCenter, const double * pSouth, double * pNew,
+                        const int & count, const double & diffusion, const double & center)
+{
+  for (int x = 0; x < count; ++x)
+    {
+      double Average = (pNorth[x - 1] + pNorth[x + 1] + pSouth[x - 1] + pSouth[x + 1] + 4.0 * (pNorth[x] + pCenter[x - 1] + pCenter[x + 1] + pSouth[x])) * 0.3;
+      pNew[x] = diffusion * Average + center * pCenter[x];
+    }
+}
+
+/*
+ * The rows of the 3D kernels are indexed by 3 * (dz + 1) + (dy + 1), i.e., pRows[4] is the center row,
+ * pRows[3] and pRows[5] are north and south, and pRows[1] and pRows[7] are above and below.
+ */
+static void scalarRow3D7(const double * const * pRows, double * pNew,
+                         const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+
+  for (int x = 0; x < count; ++x)
+    {
+      double Average = (pCenter[x - 1] + pCenter[x + 1] + pRows[3][x] + pRows[5][x] + pRows[1][x] + pRows[7][x]) * 1.8;
+      pNew[x] = diffusion * Average + center * pCenter[x];
+    }
+}
+
+static void scalarRow3D27(const double * const * pRows, double * pNew,
+                          const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+
+  for (int x = 0; x < count; ++x)
+    {
+      double Face = pCenter[x - 1] + pCenter[x + 1] + pRows[3][x] + pRows[5][x] + pRows[1][x] + pRows[7][x];
+      double Edge = pRows[3][x - 1] + pRows[3][x + 1] + pRows[5][x - 1] + pRows[5][x + 1]
+                    + pRows[1][x - 1] + pRows[1][x + 1] + pRows[7][x - 1] + pRows[7][x + 1]
+                    + pRows[0][x] + pRows[2][x] + pRows[6][x] + pRows[8][x];
+      double Corner = pRows[0][x - 1] + pRows[0][x + 1] + pRows[2][x - 1] + pRows[2][x + 1]
+                      + pRows[6][x - 1] + pRows[6][x + 1] + pRows[8][x - 1] + pRows[8][x + 1];
+      double Average = (4.0 * Face + Edge + Corner) * 0.15;
+      pNew[x] = diffusion * Average + center * pCenter[x];
+    }
+}
+
+#ifdef ENISI_X86_KERNELS
+
+__attribute__((target("sse2")))
+static void sse2Row2D(const double * pNorth, const double * pCenter, const double * pSouth, double * pNew,
+                      const int & count, const double & diffusion, const double & center)
+{
+  const __m128d Four = _mm_set1_pd(4.0);
+  const __m128d Weight = _mm_set1_pd(0.3);
+  const __m128d Diffusion = _mm_set1_pd(diffusion);
+  const __m128d Center = _mm_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 2 <= count; x += 2)
+    {
+      __m128d Diagonal = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_loadu_pd(pNorth + x - 1), _mm_loadu_pd(pNorth + x + 1)), _mm_loadu_pd(pSouth + x - 1)), _mm_loadu_pd(pSouth + x + 1));
+      __m128d Direct = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_loadu_pd(pNorth + x), _mm_loadu_pd(pCenter + x - 1)), _mm_loadu_pd(pCenter + x + 1)), _mm_loadu_pd(pSouth + x));
+      __m128d Average = _mm_mul_pd(_mm_add_pd(Diagonal, _mm_mul_pd(Four, Direct)), Weight);
+
+      _mm_storeu_pd(pNew + x, _mm_add_pd(_mm_mul_pd(Diffusion, Average), _mm_mul_pd(Center, _mm_loadu_pd(pCenter + x))));
+    }
+
+  scalarRow2D(pNorth + x, pCenter + x, pSouth + x, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("avx2")))
+static void avx2Row2D(const double * pNorth, const double * pCenter, const double * pSouth, double * pNew,
+                      const int & count, const double & diffusion, const double & center)
+{
+  const __m256d Four = _mm256_set1_pd(4.0);
+  const __m256d Weight = _mm256_set1_pd(0.3);
+  const __m256d Diffusion = _mm256_set1_pd(diffusion);
+  const __m256d Center = _mm256_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 4 <= count; x += 4)
+    {
+      __m256d Diagonal = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(pNorth + x - 1), _mm256_loadu_pd(pNorth + x + 1)), _mm256_loadu_pd(pSouth + x - 1)), _mm256_loadu_pd(pSouth + x + 1));
+      __m256d Direct = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(pNorth + x), _mm256_loadu_pd(pCenter + x - 1)), _mm256_loadu_pd(pCenter + x + 1)), _mm256_loadu_pd(pSouth + x));
+      __m256d Average = _mm256_mul_pd(_mm256_add_pd(Diagonal, _mm256_mul_pd(Four, Direct)), Weight);
+
+      _mm256_storeu_pd(pNew + x, _mm256_add_pd(_mm256_mul_pd(Diffusion, Average), _mm256_mul_pd(Center, _mm256_loadu_pd(pCenter + x))));
+    }
+
+  sse2Row2D(pNorth + x, pCenter + x, pSouth + x, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("avx512f")))
+static void avx512Row2D(const double * pNorth, const double * pCenter, const double * pSouth, double * pNew,
+                        const int & count, const double & diffusion, const double & center)
+{
+  const __m512d Four = _mm512_set1_pd(4.0);
+  const __m512d Weight = _mm512_set1_pd(0.3);
+  const __m512d Diffusion = _mm512_set1_pd(diffusion);
+  const __m512d Center = _mm512_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 8 <= count; x += 8)
+    {
+      __m512d Diagonal = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_loadu_pd(pNorth + x - 1), _mm512_loadu_pd(pNorth + x + 1)), _mm512_loadu_pd(pSouth + x - 1)), _mm512_loadu_pd(pSouth + x + 1));
+      __m512d Direct = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_loadu_pd(pNorth + x), _mm512_loadu_pd(pCenter + x - 1)), _mm512_loadu_pd(pCenter + x + 1)), _mm512_loadu_pd(pSouth + x));
+      __m512d Average = _mm512_mul_pd(_mm512_add_pd(Diagonal, _mm512_mul_pd(Four, Direct)), Weight);
+
+      _mm512_storeu_pd(pNew + x, _mm512_add_pd(_mm512_mul_pd(Diffusion, Average), _mm512_mul_pd(Center, _mm512_loadu_pd(pCenter + x))));
+    }
+
+  avx2Row2D(pNorth + x, pCenter + x, pSouth + x, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("sse2")))
+static void sse2Row3D7(const double * const * pRows, double * pNew,
+                       const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+  const __m128d Weight = _mm_set1_pd(1.8);
+  const __m128d Diffusion = _mm_set1_pd(diffusion);
+  const __m128d Center = _mm_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 2 <= count; x += 2)
+    {
+      __m128d Face = _mm_add_pd(_mm_loadu_pd(pCenter + x - 1), _mm_loadu_pd(pCenter + x + 1));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[3] + x));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[5] + x));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[1] + x));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[7] + x));
+      __m128d Average = _mm_mul_pd(Face, Weight);
+
+      _mm_storeu_pd(pNew + x, _mm_add_pd(_mm_mul_pd(Diffusion, Average), _mm_mul_pd(Center, _mm_loadu_pd(pCenter + x))));
+    }
+
+  const double * Tail[9];
+
+  for (int i = 0; i < 9; ++i)
+    {
+      Tail[i] = pRows[i] + x;
+    }
+
+  scalarRow3D7(Tail, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("sse2")))
+static void sse2Row3D27(const double * const * pRows, double * pNew,
+                        const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+  const __m128d Four = _mm_set1_pd(4.0);
+  const __m128d Weight = _mm_set1_pd(0.15);
+  const __m128d Diffusion = _mm_set1_pd(diffusion);
+  const __m128d Center = _mm_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 2 <= count; x += 2)
+    {
+      __m128d Face = _mm_add_pd(_mm_loadu_pd(pCenter + x - 1), _mm_loadu_pd(pCenter + x + 1));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[3] + x));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[5] + x));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[1] + x));
+      Face = _mm_add_pd(Face, _mm_loadu_pd(pRows[7] + x));
+      __m128d Edge = _mm_add_pd(_mm_loadu_pd(pRows[3] + x - 1), _mm_loadu_pd(pRows[3] + x + 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[5] + x - 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[5] + x + 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[1] + x - 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[1] + x + 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[7] + x - 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[7] + x + 1));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[0] + x));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[2] + x));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[6] + x));
+      Edge = _mm_add_pd(Edge, _mm_loadu_pd(pRows[8] + x));
+      __m128d Corner = _mm_add_pd(_mm_loadu_pd(pRows[0] + x - 1), _mm_loadu_pd(pRows[0] + x + 1));
+      Corner = _mm_add_pd(Corner, _mm_loadu_pd(pRows[2] + x - 1));
+      Corner = _mm_add_pd(Corner, _mm_loadu_pd(pRows[2] + x + 1));
+      Corner = _mm_add_pd(Corner, _mm_loadu_pd(pRows[6] + x - 1));
+      Corner = _mm_add_pd(Corner, _mm_loadu_pd(pRows[6] + x + 1));
+      Corner = _mm_add_pd(Corner, _mm_loadu_pd(pRows[8] + x - 1));
+      Corner = _mm_add_pd(Corner, _mm_loadu_pd(pRows[8] + x + 1));
+      __m128d Average = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(Four, Face), Edge), Corner), Weight);
+
+      _mm_storeu_pd(pNew + x, _mm_add_pd(_mm_mul_pd(Diffusion, Average), _mm_mul_pd(Center, _mm_loadu_pd(pCenter + x))));
+    }
+
+  const double * Tail[9];
+
+  for (int i = 0; i < 9; ++i)
+    {
+      Tail[i] = pRows[i] + x;
+    }
+
+  scalarRow3D27(Tail, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("avx2")))
+static void avx2Row3D7(const double * const * pRows, double * pNew,
+                       const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+  const __m256d Weight = _mm256_set1_pd(1.8);
+  const __m256d Diffusion = _mm256_set1_pd(diffusion);
+  const __m256d Center = _mm256_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 4 <= count; x += 4)
+    {
+      __m256d Face = _mm256_add_pd(_mm256_loadu_pd(pCenter + x - 1), _mm256_loadu_pd(pCenter + x + 1));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[3] + x));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[5] + x));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[1] + x));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[7] + x));
+      __m256d Average = _mm256_mul_pd(Face, Weight);
+
+      _mm256_storeu_pd(pNew + x, _mm256_add_pd(_mm256_mul_pd(Diffusion, Average), _mm256_mul_pd(Center, _mm256_loadu_pd(pCenter + x))));
+    }
+
+  const double * Tail[9];
+
+  for (int i = 0; i < 9; ++i)
+    {
+      Tail[i] = pRows[i] + x;
+    }
+
+  sse2Row3D7(Tail, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("avx2")))
+static void avx2Row3D27(const double * const * pRows, double * pNew,
+                        const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+  const __m256d Four = _mm256_set1_pd(4.0);
+  const __m256d Weight = _mm256_set1_pd(0.15);
+  const __m256d Diffusion = _mm256_set1_pd(diffusion);
+  const __m256d Center = _mm256_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 4 <= count; x += 4)
+    {
+      __m256d Face = _mm256_add_pd(_mm256_loadu_pd(pCenter + x - 1), _mm256_loadu_pd(pCenter + x + 1));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[3] + x));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[5] + x));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[1] + x));
+      Face = _mm256_add_pd(Face, _mm256_loadu_pd(pRows[7] + x));
+      __m256d Edge = _mm256_add_pd(_mm256_loadu_pd(pRows[3] + x - 1), _mm256_loadu_pd(pRows[3] + x + 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[5] + x - 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[5] + x + 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[1] + x - 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[1] + x + 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[7] + x - 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[7] + x + 1));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[0] + x));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[2] + x));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[6] + x));
+      Edge = _mm256_add_pd(Edge, _mm256_loadu_pd(pRows[8] + x));
+      __m256d Corner = _mm256_add_pd(_mm256_loadu_pd(pRows[0] + x - 1), _mm256_loadu_pd(pRows[0] + x + 1));
+      Corner = _mm256_add_pd(Corner, _mm256_loadu_pd(pRows[2] + x - 1));
+      Corner = _mm256_add_pd(Corner, _mm256_loadu_pd(pRows[2] + x + 1));
+      Corner = _mm256_add_pd(Corner, _mm256_loadu_pd(pRows[6] + x - 1));
+      Corner = _mm256_add_pd(Corner, _mm256_loadu_pd(pRows[6] + x + 1));
+      Corner = _mm256_add_pd(Corner, _mm256_loadu_pd(pRows[8] + x - 1));
+      Corner = _mm256_add_pd(Corner, _mm256_loadu_pd(pRows[8] + x + 1));
+      __m256d Average = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(Four, Face), Edge), Corner), Weight);
+
+      _mm256_storeu_pd(pNew + x, _mm256_add_pd(_mm256_mul_pd(Diffusion, Average), _mm256_mul_pd(Center, _mm256_loadu_pd(pCenter + x))));
+    }
+
+  const double * Tail[9];
+
+  for (int i = 0; i < 9; ++i)
+    {
+      Tail[i] = pRows[i] + x;
+    }
+
+  sse2Row3D27(Tail, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("avx512f")))
+static void avx512Row3D7(const double * const * pRows, double * pNew,
+                         const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+  const __m512d Weight = _mm512_set1_pd(1.8);
+  const __m512d Diffusion = _mm512_set1_pd(diffusion);
+  const __m512d Center = _mm512_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 8 <= count; x += 8)
+    {
+      __m512d Face = _mm512_add_pd(_mm512_loadu_pd(pCenter + x - 1), _mm512_loadu_pd(pCenter + x + 1));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[3] + x));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[5] + x));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[1] + x));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[7] + x));
+      __m512d Average = _mm512_mul_pd(Face, Weight);
+
+      _mm512_storeu_pd(pNew + x, _mm512_add_pd(_mm512_mul_pd(Diffusion, Average), _mm512_mul_pd(Center, _mm512_loadu_pd(pCenter + x))));
+    }
+
+  const double * Tail[9];
+
+  for (int i = 0; i < 9; ++i)
+    {
+      Tail[i] = pRows[i] + x;
+    }
+
+  avx2Row3D7(Tail, pNew + x, count - x, diffusion, center);
+}
+
+__attribute__((target("avx512f")))
+static void avx512Row3D27(const double * const * pRows, double * pNew,
+                          const int & count, const double & diffusion, const double & center)
+{
+  const double * pCenter = pRows[4];
+  const __m512d Four = _mm512_set1_pd(4.0);
+  const __m512d Weight = _mm512_set1_pd(0.15);
+  const __m512d Diffusion = _mm512_set1_pd(diffusion);
+  const __m512d Center = _mm512_set1_pd(center);
+
+  int x = 0;
+
+  for (; x + 8 <= count; x += 8)
+    {
+      __m512d Face = _mm512_add_pd(_mm512_loadu_pd(pCenter + x - 1), _mm512_loadu_pd(pCenter + x + 1));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[3] + x));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[5] + x));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[1] + x));
+      Face = _mm512_add_pd(Face, _mm512_loadu_pd(pRows[7] + x));
+      __m512d Edge = _mm512_add_pd(_mm512_loadu_pd(pRows[3] + x - 1), _mm512_loadu_pd(pRows[3] + x + 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[5] + x - 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[5] + x + 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[1] + x - 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[1] + x + 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[7] + x - 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[7] + x + 1));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[0] + x));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[2] + x));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[6] + x));
+      Edge = _mm512_add_pd(Edge, _mm512_loadu_pd(pRows[8] + x));
+      __m512d Corner = _mm512_add_pd(_mm512_loadu_pd(pRows[0] + x - 1), _mm512_loadu_pd(pRows[0] + x + 1));
+      Corner = _mm512_add_pd(Corner, _mm512_loadu_pd(pRows[2] + x - 1));
+      Corner = _mm512_add_pd(Corner, _mm512_loadu_pd(pRows[2] + x + 1));
+      Corner = _mm512_add_pd(Corner, _mm512_loadu_pd(pRows[6] + x - 1));
+      Corner = _mm512_add_pd(Corner, _mm512_loadu_pd(pRows[6] + x + 1));
+      Corner = _mm512_add_pd(Corner, _mm512_loadu_pd(pRows[8] + x - 1));
+      Corner = _mm512_add_pd(Corner, _mm512_loadu_pd(pRows[8] + x + 1));
+      __m512d Average = _mm512_mul_pd(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(Four, Face), Edge), Corner), Weight);
+
+      _mm512_storeu_pd(pNew + x, _mm512_add_pd(_mm512_mul_pd(Diffusion, Average), _mm512_mul_pd(Center, _mm512_loadu_pd(pCenter + x))));
+    }
+
+  const double * Tail[9];
+
+  for (int i = 0; i < 9; ++i)
+    {
+      Tail[i] = pRows[i] + x;
+    }
+
+  avx2Row3D27(Tail, pNew + x, count - x, diffusion, center);
+}
+
+#endif // ENISI_X86_KERNELS
+
+// static
+bool StencilKernel::isSupported(const StencilKernel::Type & type)
+{
+  switch (type)
+    {
+      case Auto:
+      case Scalar:
+        return true;
+
+#ifdef ENISI_X86_KERNELS
+      case SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+
+      case AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+
+      case AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+#else
+      default:
+        break;
+#endif
+    }
+
+  return false;
+}
+
+// static
+StencilKernel::Type StencilKernel::select(const StencilKernel::Type & requested)
+{
+  int Type = (requested == Auto) ? AVX512 : requested;
+
+  while (Type > Scalar && !isSupported((StencilKernel::Type) Type))
+    {
+      Type--;
+    }
+
+  return (StencilKernel::Type) Type;
+}
+
+// static
+StencilKernel::Row2D StencilKernel::row2D(const StencilKernel::Type & type)
+{
+  switch (select(type))
+    {
+#ifdef ENISI_X86_KERNELS
+      case SSE2:
+        return sse2Row2D;
+
+      case AVX2:
+        return avx2Row2D;
+
+      case AVX512:
+        return avx512Row2D;
+#endif
+
+      default:
+        break;
+    }
+
+  return scalarRow2D;
+}
+
+// static
+StencilKernel::Row3D StencilKernel::row3D(const StencilKernel::Type & type, const StencilKernel::Stencil3D & stencil)
+{
+  bool Box = (stencil == Point27);
+
+  switch (select(type))
+    {
+#ifdef ENISI_X86_KERNELS
+      case SSE2:
+        return Box ? sse2Row3D27 : sse2Row3D7;
+
+      case AVX2:
+        return Box ? avx2Row3D27 : avx2Row3D7;
+
+      case AVX512:
+        return Box ? avx512Row3D27 : avx512Row3D7;
+#endif
+
+      default:
+        break;
+    }
+
+  return Box ? scalarRow3D27 : scalarRow3D7;
+}
+
+// static
+double StencilKernel::centerWeight(const size_t & dimensions, const StencilKernel::Stencil3D & stencil)
+{
+  switch (dimensions)
+  {
+    case 1:
+      return 2.0;
+
+    case 2:
+      // (4 * 4 + 4) * 0.3
+      return 6.0;
+
+    default:
+      break;
+  }
+
+  // 7 point: 6 * 1.8; 27 point: (6 * 4 + 12 + 8) * 0.15
+  return (stencil == Point27) ? 6.6 : 10.8;
+}
@@ -0,0 +1,89 @@
+/*
+ * StencilKernel.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#ifndef DIFFUSER_STENCILKERNEL_H_
+#define DIFFUSER_STENCILKERNEL_H_
+
+#include <cstddef>
+
+namespace ENISI
+{
+
+/**
+ * Row kernels for the weighted 9 point stencil used by the 2D sweep of ExplicitSweep and the
+ * 7 point or 27 point stencils used by its 3D sweep.
+ * The kernels update the cells [0, count) of a row and read the cells [-1, count] of the
+ * neighboring rows, i.e., the ghost ring must hold the boundary values.
+ *
+ * All stencils have the effective diffusion coefficient 1.8 * diffusion of the 2D stencil. The
+ * 27 point stencil uses the 2D weighting, i.e., face neighbors have 4 times the weight of the
+ * edge and corner neighbors.
+ *
+ * All implementations perform the floating point operations in the same order as
+ * the scalar implementation and therefore produce bitwise identical results, which is
+ * tested by testmain (test.cpp).
+ */
+class StencilKernel
+{
+public:
+  static const char* TypeNames[];
+
+  enum Type { Auto, Scalar, SSE2, AVX2, AVX512 };
+
+  static const char* Stencil3DNames[];
+
+  enum Stencil3D { Point7, Point27 };
+
+  /**
+   * @param const double * pNorth (row y - 1)
+   * @param const double * pCenter (row y)
+   * @param const double * pSouth (row y + 1)
+   * @param double * pNew (updated row y)
+   * @param const int & count (number of cells to update)
+   * @param const double & diffusion (deltaT * diffusion)
+   * @param const double & center (1 - deltaT * (degradation + centerWeight(2, stencil) * diffusion))
+   */
+  typedef void (*Row2D)(const double * pNorth, const double * pCenter, const double * pSouth, double * pNew,
+                        const int & count, const double & diffusion, const double & center);
+
+  /**
+   * @param const double * const * pRows (the 9 rows (y + dy, z + dz) indexed by 3 * (dz + 1) + (dy + 1))
+   * @param double * pNew (updated row (y, z))
+   * @param const int & count (number of cells to update)
+   * @param const double & diffusion (deltaT * diffusion)
+   * @param const double & center (1 - deltaT * (degradation + centerWeight(3, stencil) * diffusion))
+   */
+  typedef void (*Row3D)(const double * const * pRows, double * pNew,
+                        const int & count, const double & diffusion, const double & center);
+
+  /**
+   * Determine the best kernel supported by the CPU which does not exceed the requested one.
+   * @param const Type & requested
+   * @return Type type
+   */
+  static Type select(const Type & requested);
+
+  static bool isSupported(const Type & type);
+
+  static Row2D row2D(const Type & type);
+
+  static Row3D row3D(const Type & type, const Stencil3D & stencil);
+
+  /**
+   * The sum of the neighbor weights of the stencil, i.e., the center value is multiplied
+   * by 1 - deltaT * (degradation + centerWeight * diffusion). 1D uses the 3 point stencil and
+   * the 3D stencil is only used for 3 dimensions.
+   */
+  static double centerWeight(const size_t & dimensions, const Stencil3D & stencil);
+
+private:
+  StencilKernel();
+};
+
+} /* namespace ENISI */
+
+#endif /* DIFFUSER_STENCILKERNEL_H_ */
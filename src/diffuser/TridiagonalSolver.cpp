@@ -0,0 +1,304 @@
+/*
+ * TridiagonalSolver.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "TridiagonalSolver.h"
+
+using namespace ENISI;
+
+// static
+MPI_Comm TridiagonalSolver::createCommunicator(MPI_Comm communicator, const std::vector< int > & ranks, const int & tag)
+{
+  if (ranks.size() < 2)
+    {
+      return MPI_COMM_SELF;
+    }
+
+  MPI_Group Group;
+  MPI_Group LineGroup;
+  MPI_Comm LineCommunicator = MPI_COMM_NULL;
+
+  MPI_Comm_group(communicator, &Group);
+  MPI_Group_incl(Group, ranks.size(), const_cast< int * >(&ranks[0]), &LineGroup);
+  MPI_Comm_create_group(communicator, LineGroup, tag, &LineCommunicator);
+  MPI_Group_free(&LineGroup);
+  MPI_Group_free(&Group);
+
+  if (LineCommunicator == MPI_COMM_NULL)
+    {
+      throw std::runtime_error("TridiagonalSolver: failed to create line communicator.");
+    }
+
+  return LineCommunicator;
+}
+
+// static
+void TridiagonalSolver::freeCommunicator(MPI_Comm & communicator)
+{
+  if (communicator != MPI_COMM_NULL &&
+      communicator != MPI_COMM_SELF)
+    {
+      MPI_Comm_free(&communicator);
+    }
+
+  communicator = MPI_COMM_NULL;
+}
+
+TridiagonalSolver::TridiagonalSolver(MPI_Comm lineCommunicator, const bool & periodic,
+                                     const int & length, const double & diagonal, const double & offDiagonal):
+  mCommunicator(lineCommunicator),
+  mProcesses(1),
+  mPosition(0),
+  mPeriodic(periodic),
+  mCoupledLow(false),
+  mCoupledHigh(false),
+  mLength(length),
+  mOffDiagonal(offDiagonal),
+  mInverse(length),
+  mUpper(length),
+  mResponseLow(length, 0.0),
+  mResponseHigh(length, 0.0),
+  mReduced(),
+  mSend(),
+  mReceive(),
+  mNeighborValues()
+{
+  MPI_Comm_size(mCommunicator, &mProcesses);
+  MPI_Comm_rank(mCommunicator, &mPosition);
+
+  mCoupledLow = mPeriodic || mPosition > 0;
+  mCoupledHigh = mPeriodic || mPosition < mProcesses - 1;
+
+  // Closed ends reflect, i.e., the neighbor value equals the end value.
+  std::vector< double > Diagonal(mLength, diagonal);
+
+  if (!mCoupledLow) Diagonal[0] -= mOffDiagonal;
+  if (!mCoupledHigh) Diagonal[mLength - 1] -= mOffDiagonal;
+
+  mInverse[0] = 1.0 / Diagonal[0];
+  mUpper[0] = mOffDiagonal * mInverse[0];
+
+  for (int i = 1; i < mLength; ++i)
+    {
+      mInverse[i] = 1.0 / (Diagonal[i] - mOffDiagonal * mUpper[i - 1]);
+      mUpper[i] = mOffDiagonal * mInverse[i];
+    }
+
+  if (mCoupledLow)
+    {
+      mResponseLow[0] = mOffDiagonal;
+      thomas(&mResponseLow[0], 1, mLength, 1);
+    }
+
+  if (mCoupledHigh)
+    {
+      mResponseHigh[mLength - 1] = mOffDiagonal;
+      thomas(&mResponseHigh[0], 1, mLength, 1);
+    }
+
+  factorReducedSystem();
+}
+
+TridiagonalSolver::~TridiagonalSolver()
+{}
+
+void TridiagonalSolver::thomas(double * pData, const int & lines, const ptrdiff_t & lineStride, const ptrdiff_t & elementStride) const
+{
+  const double & r = mOffDiagonal;
+
+  if (elementStride == 1)
+    {
+      for (int l = 0; l < lines; ++l)
+        {
+          double * pLine = pData + l * lineStride;
+
+          pLine[0] *= mInverse[0];
+
+          for (int i = 1; i < mLength; ++i)
+            {
+              pLine[i] = (pLine[i] + r * pLine[i - 1]) * mInverse[i];
+            }
+
+          for (int i = mLength - 2; i >= 0; --i)
+            {
+              pLine[i] += mUpper[i] * pLine[i + 1];
+            }
+        }
+
+      return;
+    }
+
+  // The lines are interleaved, i.e., we sweep all lines simultaneously.
+  for (int l = 0; l < lines; ++l)
+    {
+      pData[l * lineStride] *= mInverse[0];
+    }
+
+  for (int i = 1; i < mLength; ++i)
+    {
+      double * pElement = pData + i * elementStride;
+      const double * pPrevious = pElement - elementStride;
+      const double & Inverse = mInverse[i];
+
+      for (int l = 0; l < lines; ++l)
+        {
+          pElement[l * lineStride] = (pElement[l * lineStride] + r * pPrevious[l * lineStride]) * Inverse;
+        }
+    }
+
+  for (int i = mLength - 2; i >= 0; --i)
+    {
+      double * pElement = pData + i * elementStride;
+      const double * pNext = pElement + elementStride;
+      const double & Upper = mUpper[i];
+
+      for (int l = 0; l < lines; ++l)
+        {
+          pElement[l * lineStride] += Upper * pNext[l * lineStride];
+        }
+    }
+}
+
+void TridiagonalSolver::factorReducedSystem()
+{
+  if (!mCoupledLow && !mCoupledHigh) return;
+
+  // The unknowns of the reduced system are the first (f) and last (g) values of each segment:
+  //   f[q] - ResponseLow[0] * g[q-1] - ResponseHigh[0] * f[q+1] = u0[0]
+  //   g[q] - ResponseLow[m-1] * g[q-1] - ResponseHigh[m-1] * f[q+1] = u0[m-1]
+  double Local[4] = {mResponseLow[0], mResponseHigh[0], mResponseLow[mLength - 1], mResponseHigh[mLength - 1]};
+  std::vector< double > All(4 * mProcesses);
+
+  if (mProcesses > 1)
+    {
+      MPI_Allgather(Local, 4, MPI_DOUBLE, &All[0], 4, MPI_DOUBLE, mCommunicator);
+    }
+  else
+    {
+      std::copy(Local, Local + 4, All.begin());
+    }
+
+  const int N = 2 * mProcesses;
+  mReduced.assign(N * N, 0.0);
+
+  for (int q = 0; q < mProcesses; ++q)
+    {
+      const double * pCoefficients = &All[4 * q];
+      double * pFirst = &mReduced[2 * q * N];
+      double * pLast = pFirst + N;
+
+      pFirst[2 * q] += 1.0;
+      pLast[2 * q + 1] += 1.0;
+
+      if (mPeriodic || q > 0)
+        {
+          int Low = 2 * ((q - 1 + mProcesses) % mProcesses) + 1;
+          pFirst[Low] -= pCoefficients[0];
+          pLast[Low] -= pCoefficients[2];
+        }
+
+      if (mPeriodic || q < mProcesses - 1)
+        {
+          int High = 2 * ((q + 1) % mProcesses);
+          pFirst[High] -= pCoefficients[1];
+          pLast[High] -= pCoefficients[3];
+        }
+    }
+
+  // The reduced system is strictly diagonally dominant, i.e., no pivoting is required.
+  for (int j = 0; j < N; ++j)
+    for (int i = j + 1; i < N; ++i)
+      {
+        double & Factor = mReduced[i * N + j];
+
+        if (Factor == 0.0) continue;
+
+        Factor /= mReduced[j * N + j];
+
+        for (int k = j + 1; k < N; ++k)
+          {
+            mReduced[i * N + k] -= Factor * mReduced[j * N + k];
+          }
+      }
+}
+
+void TridiagonalSolver::solve(double * pData, const int & lines, const ptrdiff_t & lineStride, const ptrdiff_t & elementStride)
+{
+  thomas(pData, lines, lineStride, elementStride);
+
+  if (!mCoupledLow && !mCoupledHigh) return;
+
+  const int N = 2 * mProcesses;
+  const ptrdiff_t Last = (mLength - 1) * elementStride;
+
+  mSend.resize(2 * lines);
+
+  for (int l = 0; l < lines; ++l)
+    {
+      mSend[2 * l] = pData[l * lineStride];
+      mSend[2 * l + 1] = pData[l * lineStride + Last];
+    }
+
+  if (mProcesses > 1)
+    {
+      mReceive.resize(mProcesses * 2 * lines);
+      MPI_Allgather(&mSend[0], 2 * lines, MPI_DOUBLE, &mReceive[0], 2 * lines, MPI_DOUBLE, mCommunicator);
+    }
+  else
+    {
+      mReceive = mSend;
+    }
+
+  std::vector< double > Z(N);
+  mNeighborValues.resize(2 * lines);
+
+  const int Low = 2 * ((mPosition - 1 + mProcesses) % mProcesses) + 1;
+  const int High = 2 * ((mPosition + 1) % mProcesses);
+
+  for (int l = 0; l < lines; ++l)
+    {
+      for (int q = 0; q < mProcesses; ++q)
+        {
+          Z[2 * q] = mReceive[q * 2 * lines + 2 * l];
+          Z[2 * q + 1] = mReceive[q * 2 * lines + 2 * l + 1];
+        }
+
+      for (int i = 1; i < N; ++i)
+        for (int j = 0; j < i; ++j)
+          {
+            Z[i] -= mReduced[i * N + j] * Z[j];
+          }
+
+      for (int i = N - 1; i >= 0; --i)
+        {
+          for (int j = i + 1; j < N; ++j)
+            {
+              Z[i] -= mReduced[i * N + j] * Z[j];
+            }
+
+          Z[i] /= mReduced[i * N + i];
+        }
+
+      mNeighborValues[2 * l] = mCoupledLow ? Z[Low] : 0.0;
+      mNeighborValues[2 * l + 1] = mCoupledHigh ? Z[High] : 0.0;
+    }
+
+  // Add the response to the neighbor values
+  for (int l = 0; l < lines; ++l)
+    {
+      double * pElement = pData + l * lineStride;
+      const double & NeighborLow = mNeighborValues[2 * l];
+      const double & NeighborHigh = mNeighborValues[2 * l + 1];
+
+      for (int i = 0; i < mLength; ++i, pElement += elementStride)
+        {
+          *pElement += NeighborLow * mResponseLow[i] + NeighborHigh * mResponseHigh[i];
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * TridiagonalSolver.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#ifndef DIFFUSER_TRIDIAGONALSOLVER_H_
+#define DIFFUSER_TRIDIAGONALSOLVER_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <mpi.h>
+
+namespace ENISI
+{
+
+/**
+ * Solver for many tridiagonal systems with constant coefficients
+ *   -r u[i-1] + b u[i] - r u[i+1] = d[i]
+ * where each line is distributed in segments over the processes of a line communicator.
+ * Closed (non periodic) ends of a line satisfy a zero flux condition, i.e., u[-1] = u[0].
+ *
+ * Each process solves its segments locally with the Thomas algorithm. The coupling to the
+ * neighboring segments is resolved with a reduced system of size 2 * processes (partition
+ * method), which requires a single Allgather of the segment end values per solve.
+ */
+class TridiagonalSolver
+{
+private:
+  TridiagonalSolver();
+  TridiagonalSolver(const TridiagonalSolver & src);
+
+public:
+  /**
+   * Create the communicator for the processes sharing a line. This is collective over the
+   * processes listed in ranks only. For a single process MPI_COMM_SELF is returned.
+   * @param MPI_Comm communicator
+   * @param const std::vector< int > & ranks (ranks of the communicator owning the segments in order)
+   * @param const int & tag
+   * @return MPI_Comm lineCommunicator
+   */
+  static MPI_Comm createCommunicator(MPI_Comm communicator, const std::vector< int > & ranks, const int & tag);
+
+  static void freeCommunicator(MPI_Comm & communicator);
+
+  /**
+   * The constructor is collective over the line communicator.
+   * @param MPI_Comm lineCommunicator
+   * @param const bool & periodic
+   * @param const int & length (length of the local segment)
+   * @param const double & diagonal (b)
+   * @param const double & offDiagonal (r)
+   */
+  TridiagonalSolver(MPI_Comm lineCommunicator, const bool & periodic,
+                    const int & length, const double & diagonal, const double & offDiagonal);
+
+  ~TridiagonalSolver();
+
+  /**
+   * Solve the systems in place, this is collective over the line communicator.
+   * The element i of line l is located at pData + l * lineStride + i * elementStride.
+   * @param double * pData
+   * @param const int & lines
+   * @param const ptrdiff_t & lineStride
+   * @param const ptrdiff_t & elementStride
+   */
+  void solve(double * pData, const int & lines, const ptrdiff_t & lineStride, const ptrdiff_t & elementStride);
+
+private:
+  void thomas(double * pData, const int & lines, const ptrdiff_t & lineStride, const ptrdiff_t & elementStride) const;
+  void factorReducedSystem();
+
+  MPI_Comm mCommunicator;
+  int mProcesses;
+  int mPosition;
+  bool mPeriodic;
+  bool mCoupledLow;
+  bool mCoupledHigh;
+
+  int mLength;
+  double mOffDiagonal;
+
+  // Thomas algorithm: inverse pivots and the negated modified super diagonal
+  std::vector< double > mInverse;
+  std::vector< double > mUpper;
+
+  // Response of the local segment to a unit value of the low and high neighbor
+  std::vector< double > mResponseLow;
+  std::vector< double > mResponseHigh;
+
+  // LU factorization of the reduced system
+  std::vector< double > mReduced;
+
+  std::vector< double > mSend;
+  std::vector< double > mReceive;
+  std::vector< double > mNeighborValues;
+};
+
+} /* namespace ENISI */
+
+#endif /* DIFFUSER_TRIDIAGONALSOLVER_H_ */
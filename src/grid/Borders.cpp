@@ -485,6 +485,11 @@ bool Borders::isPeriodic() const
   return true;
 }
 
+const repast::GridDimensions & Borders::dimensions() const
+{
+  return _dimensions;
+}
+
 SimpleBorders::SimpleBorders():
   repast::Borders(repast::GridDimensions())
 {}
@@ -50,6 +50,8 @@ public:
 
   bool isPeriodic() const;
 
+  const repast::GridDimensions & dimensions() const;
+
 protected:
   size_t mDimension;
 
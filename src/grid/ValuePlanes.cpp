@@ -0,0 +1,239 @@
+/*
+ * ValuePlanes.cpp
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "ValuePlanes.h"
+
+using namespace ENISI;
+
+// static
+const size_t ValuePlanes::ALIGNMENT = 64;
+
+static size_t alignUp(const size_t & count)
+{
+  static const size_t Doubles = ValuePlanes::ALIGNMENT / sizeof(double);
+
+  return ((count + Doubles - 1) / Doubles) * Doubles;
+}
+
+ValuePlanes::ValuePlanes(const repast::Point< int > & shape,
+                         const size_t & planes,
+                         const int & halo,
+                         const double & value):
+  mShape(shape),
+  mPlanes(planes),
+  mHalo(halo),
+  mStride(0),
+  mSlice(0),
+  mPlaneSize(0),
+  mOrigin(0),
+  mpData(NULL)
+{
+  allocate();
+  fill(value);
+}
+
+ValuePlanes::ValuePlanes(const ValuePlanes & src):
+  mShape(src.mShape),
+  mPlanes(src.mPlanes),
+  mHalo(src.mHalo),
+  mStride(0),
+  mSlice(0),
+  mPlaneSize(0),
+  mOrigin(0),
+  mpData(NULL)
+{
+  allocate();
+  memcpy(mpData, src.mpData, mPlanes * mPlaneSize * sizeof(double));
+}
+
+ValuePlanes::~ValuePlanes()
+{
+  free(mpData);
+}
+
+ValuePlanes & ValuePlanes::operator = (const ValuePlanes & rhs)
+{
+  if (&rhs == this) return *this;
+
+  if (mPlanes * mPlaneSize != rhs.mPlanes * rhs.mPlaneSize ||
+      !(mShape == rhs.mShape) ||
+      mHalo != rhs.mHalo)
+    {
+      free(mpData);
+      mpData = NULL;
+
+      mShape = rhs.mShape;
+      mPlanes = rhs.mPlanes;
+      mHalo = rhs.mHalo;
+      allocate();
+    }
+
+  memcpy(mpData, rhs.mpData, mPlanes * mPlaneSize * sizeof(double));
+
+  return *this;
+}
+
+void ValuePlanes::allocate()
+{
+  for (size_t i = 0; i < 3; ++i)
+    {
+      if (i < mShape.dimensionCount())
+        {
+          mExtent[i] = mShape[i];
+          mHaloWidth[i] = mHalo;
+        }
+      else
+        {
+          mExtent[i] = 1;
+          mHaloWidth[i] = 0;
+        }
+    }
+
+  // The front padding assures that the first interior cell of each row is aligned.
+  size_t Front = alignUp(mHaloWidth[0]);
+
+  mStride = alignUp(Front + mExtent[0] + mHaloWidth[0]);
+  mSlice = mStride * (mExtent[1] + 2 * mHaloWidth[1]);
+  mPlaneSize = mSlice * (mExtent[2] + 2 * mHaloWidth[2]);
+  mOrigin = mHaloWidth[2] * mSlice + mHaloWidth[1] * mStride + Front;
+
+  void * pData = NULL;
+
+  if (posix_memalign(&pData, ALIGNMENT, std::max< size_t >(1, mPlanes * mPlaneSize) * sizeof(double)) != 0)
+    {
+      throw std::bad_alloc();
+    }
+
+  mpData = static_cast< double * >(pData);
+}
+
+void ValuePlanes::fill(const double & value)
+{
+  std::fill(mpData, mpData + mPlanes * mPlaneSize, value);
+}
+
+void ValuePlanes::fill(const size_t & plane, const double & value)
+{
+  double * pPlane = mpData + plane * mPlaneSize;
+  std::fill(pPlane, pPlane + mPlaneSize, value);
+}
+
+void ValuePlanes::scale(const size_t & plane, const double & factor)
+{
+  double * pValue = mpData + plane * mPlaneSize;
+  double * pEnd = pValue + mPlaneSize;
+
+  for (; pValue != pEnd; ++pValue)
+    {
+      *pValue *= factor;
+    }
+}
+
+void ValuePlanes::getCell(const int & x, const int & y, std::vector< double > & values, const int & z) const
+{
+  values.resize(mPlanes);
+
+  const double * pValue = mpData + offset(x, y, z);
+  std::vector< double >::iterator it = values.begin();
+  std::vector< double >::iterator end = values.end();
+
+  for (; it != end; ++it, pValue += mPlaneSize)
+    {
+      *it = *pValue;
+    }
+}
+
+void ValuePlanes::setCell(const int & x, const int & y, const std::vector< double > & values, const int & z)
+{
+  double * pValue = mpData + offset(x, y, z);
+  std::vector< double >::const_iterator it = values.begin();
+  std::vector< double >::const_iterator end = values.end();
+
+  for (; it != end; ++it, pValue += mPlaneSize)
+    {
+      *pValue = *it;
+    }
+}
+
+void ValuePlanes::copyCell(const int & xTo, const int & yTo, const int & xFrom, const int & yFrom, const int & z)
+{
+  double * pTo = mpData + offset(xTo, yTo, z);
+  const double * pFrom = mpData + offset(xFrom, yFrom, z);
+
+  for (size_t k = 0; k < mPlanes; ++k, pTo += mPlaneSize, pFrom += mPlaneSize)
+    {
+      *pTo = *pFrom;
+    }
+}
+
+void ValuePlanes::getCell(const int & x, const int & y, const std::vector< size_t > & planes, std::vector< double > & values, const int & z) const
+{
+  values.resize(planes.size());
+
+  const double * pValue = mpData + offset(x, y, z);
+  std::vector< size_t >::const_iterator itPlane = planes.begin();
+  std::vector< double >::iterator it = values.begin();
+  std::vector< double >::iterator end = values.end();
+
+  for (; it != end; ++it, ++itPlane)
+    {
+      *it = pValue[*itPlane * mPlaneSize];
+    }
+}
+
+void ValuePlanes::setCell(const int & x, const int & y, const std::vector< size_t > & planes, const std::vector< double > & values, const int & z)
+{
+  double * pValue = mpData + offset(x, y, z);
+  std::vector< size_t >::const_iterator itPlane = planes.begin();
+  std::vector< double >::const_iterator it = values.begin();
+  std::vector< double >::const_iterator end = values.end();
+
+  for (; it != end; ++it, ++itPlane)
+    {
+      pValue[*itPlane * mPlaneSize] = *it;
+    }
+}
+
+void ValuePlanes::copyPlane(const size_t & plane, const ValuePlanes & src)
+{
+  memcpy(mpData + plane * mPlaneSize, src.mpData + plane * src.mPlaneSize, mPlaneSize * sizeof(double));
+}
+
+const repast::Point< int > & ValuePlanes::shape() const
+{
+  return mShape;
+}
+
+const size_t & ValuePlanes::planes() const
+{
+  return mPlanes;
+}
+
+const int & ValuePlanes::halo() const
+{
+  return mHalo;
+}
+
+const size_t & ValuePlanes::stride() const
+{
+  return mStride;
+}
+
+const size_t & ValuePlanes::slice() const
+{
+  return mSlice;
+}
+
+const size_t & ValuePlanes::planeSize() const
+{
+  return mPlaneSize;
+}
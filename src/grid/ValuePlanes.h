@@ -0,0 +1,147 @@
+/*
+ * ValuePlanes.h
+ *
+ *  Created on: Oct 15, 2026
+ *      Author: agent
+ */
+
+#ifndef GRID_VALUEPLANES_H_
+#define GRID_VALUEPLANES_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "repast_hpc/Point.h"
+
+namespace ENISI
+{
+
+/**
+ * Structure of arrays storage for the values (e.g. cytokines) of a local grid.
+ * Each value is stored in its own contiguous plane which includes the halo ring.
+ * Rows are padded such that the first interior cell of each row is aligned,
+ * which allows streaming sweeps over a plane.
+ *
+ * Cells are addressed relative to the first interior cell, i.e., the halo ring
+ * is located at the coordinates -halo, ..., -1 and shape, ..., shape + halo - 1.
+ */
+class ValuePlanes
+{
+private:
+  ValuePlanes();
+
+public:
+  /**
+   * The alignment of rows and planes in bytes
+   */
+  static const size_t ALIGNMENT;
+
+  /**
+   * @param const repast::Point< int > & shape (interior extents; 1, 2, or 3 dimensions)
+   * @param const size_t & planes (number of values per cell)
+   * @param const int & halo (width of the halo ring)
+   * @param const double & value (initial value of all cells)
+   */
+  ValuePlanes(const repast::Point< int > & shape,
+              const size_t & planes,
+              const int & halo = 1,
+              const double & value = 0.0);
+
+  ValuePlanes(const ValuePlanes & src);
+
+  ~ValuePlanes();
+
+  ValuePlanes & operator = (const ValuePlanes & rhs);
+
+  void fill(const double & value);
+  void fill(const size_t & plane, const double & value);
+  void scale(const size_t & plane, const double & factor);
+
+  double * plane(const size_t & plane);
+  const double * plane(const size_t & plane) const;
+
+  double * row(const size_t & plane, const int & y, const int & z = 0);
+  const double * row(const size_t & plane, const int & y, const int & z = 0) const;
+
+  double & operator()(const size_t & plane, const int & x, const int & y = 0, const int & z = 0);
+  const double & operator()(const size_t & plane, const int & x, const int & y = 0, const int & z = 0) const;
+
+  void getCell(const int & x, const int & y, std::vector< double > & values, const int & z = 0) const;
+  void setCell(const int & x, const int & y, const std::vector< double > & values, const int & z = 0);
+  void copyCell(const int & xTo, const int & yTo, const int & xFrom, const int & yFrom, const int & z = 0);
+
+  /**
+   * Access the values of the selected planes of a cell only, i.e., values[i] belongs to planes[i].
+   */
+  void getCell(const int & x, const int & y, const std::vector< size_t > & planes, std::vector< double > & values, const int & z = 0) const;
+  void setCell(const int & x, const int & y, const std::vector< size_t > & planes, const std::vector< double > & values, const int & z = 0);
+
+  /**
+   * Copy the plane including the halo ring from src, which must have the same layout.
+   */
+  void copyPlane(const size_t & plane, const ValuePlanes & src);
+
+  const repast::Point< int > & shape() const;
+  const size_t & planes() const;
+  const int & halo() const;
+  const size_t & stride() const;
+  const size_t & slice() const;
+  const size_t & planeSize() const;
+
+private:
+  void allocate();
+  size_t offset(const int & x, const int & y, const int & z) const;
+
+  repast::Point< int > mShape;
+  size_t mPlanes;
+  int mHalo;
+
+  // Extents and halo width for x, y, and z; unused dimensions have extent 1 and no halo
+  int mExtent[3];
+  int mHaloWidth[3];
+
+  size_t mStride;     // distance between rows
+  size_t mSlice;      // distance between z-slices
+  size_t mPlaneSize;  // distance between planes
+  size_t mOrigin;     // offset of the first interior cell within a plane
+  double * mpData;
+};
+
+inline size_t ValuePlanes::offset(const int & x, const int & y, const int & z) const
+{
+  return mOrigin + z * mSlice + y * mStride + x;
+}
+
+inline double * ValuePlanes::plane(const size_t & plane)
+{
+  return mpData + plane * mPlaneSize + mOrigin;
+}
+
+inline const double * ValuePlanes::plane(const size_t & plane) const
+{
+  return mpData + plane * mPlaneSize + mOrigin;
+}
+
+inline double * ValuePlanes::row(const size_t & plane, const int & y, const int & z)
+{
+  return mpData + plane * mPlaneSize + offset(0, y, z);
+}
+
+inline const double * ValuePlanes::row(const size_t & plane, const int & y, const int & z) const
+{
+  return mpData + plane * mPlaneSize + offset(0, y, z);
+}
+
+inline double & ValuePlanes::operator()(const size_t & plane, const int & x, const int & y, const int & z)
+{
+  return mpData[plane * mPlaneSize + offset(x, y, z)];
+}
+
+inline const double & ValuePlanes::operator()(const size_t & plane, const int & x, const int & y, const int & z) const
+{
+  return mpData[plane * mPlaneSize + offset(x, y, z)];
+}
+
+} /* namespace ENISI */
+
+#endif /* GRID_VALUEPLANES_H_ */
@@ -0,0 +1,235 @@
+/*
+ * test.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: agent
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "diffuser/ExplicitSweep.h"
+#include "diffuser/StencilKernel.h"
+#include "grid/ValuePlanes.h"
+
+using namespace ENISI;
+
+// The vectorized stencil kernels must reproduce the results of the scalar kernel bitwise, independent
+// of the threads, tiles, and the swept planes. The reference sweeps each plane on its own with the
+// scalar kernel.
+
+static const size_t PLANES = 6;
+static const double DIFFUSION[PLANES] = {0.11, 0.05, 0.2, 0.013, 0.08, 0.15};
+static const double DEGRADATION[PLANES] = {0.01, 0.0, 0.3, 0.002, 0.05, 0.1};
+
+static size_t Failures = 0;
+
+static ExplicitSweep::Region extent(const repast::Point< int > & shape, const int & ghosts)
+{
+  ExplicitSweep::Region Extent;
+
+  for (size_t d = 0; d < 3; ++d)
+    {
+      Extent.lower[d] = 0;
+      Extent.upper[d] = 1;
+    }
+
+  for (size_t d = 0; d < shape.dimensionCount(); ++d)
+    {
+      Extent.lower[d] = -ghosts;
+      Extent.upper[d] = shape[d] + ghosts;
+    }
+
+  return Extent;
+}
+
+/**
+ * Fill all cells including the halo ring with random values in [-1, 1).
+ */
+static void seed(ValuePlanes & values, const unsigned int & seed)
+{
+  const ExplicitSweep::Region Extent = extent(values.shape(), values.halo());
+  srand(seed);
+
+  for (size_t k = 0; k < values.planes(); ++k)
+    for (int z = Extent.lower[2]; z < Extent.upper[2]; ++z)
+      for (int y = Extent.lower[1]; y < Extent.upper[1]; ++y)
+        for (int x = Extent.lower[0]; x < Extent.upper[0]; ++x)
+          {
+            values(k, x, y, z) = 2.0 * rand() / (RAND_MAX + 1.0) - 1.0;
+          }
+}
+
+/**
+ * Compare all cells including the halo ring bitwise.
+ */
+static bool equal(const ValuePlanes & values, const ValuePlanes & expected)
+{
+  const ExplicitSweep::Region Extent = extent(values.shape(), values.halo());
+  const size_t Row = (Extent.upper[0] - Extent.lower[0]) * sizeof(double);
+
+  for (size_t k = 0; k < values.planes(); ++k)
+    for (int z = Extent.lower[2]; z < Extent.upper[2]; ++z)
+      for (int y = Extent.lower[1]; y < Extent.upper[1]; ++y)
+        if (memcmp(values.row(k, y, z) + Extent.lower[0], expected.row(k, y, z) + Extent.lower[0], Row) != 0)
+          return false;
+
+  return true;
+}
+
+static void check(const std::string & name, const bool & passed)
+{
+  std::cout << (passed ? "passed: " : "FAILED: ") << name << std::endl;
+
+  if (!passed) ++Failures;
+}
+
+/**
+ * Sweep steps explicit steps over the extent with the given number of ghost layers with each supported
+ * kernel, thread count, and once for all planes and once plane by plane, and compare with the reference.
+ */
+static void testSweep(const repast::Point< int > & shape, const int & halo,
+                      const StencilKernel::Stencil3D & stencil,
+                      const int & tileX, const int & tileY, const int & steps)
+{
+  const std::vector< double > Diffusion(DIFFUSION, DIFFUSION + PLANES);
+  const std::vector< double > Degradation(DEGRADATION, DEGRADATION + PLANES);
+  const ExplicitSweep::Region Region = extent(shape, halo - steps);
+  const double DeltaT = 0.25;
+
+  std::vector< size_t > AllPlanes;
+  std::vector< std::vector< size_t > > SinglePlanes;
+
+  for (size_t k = 0; k < PLANES; ++k)
+    {
+      AllPlanes.push_back(k);
+      SinglePlanes.push_back(std::vector< size_t >(1, k));
+    }
+
+  ValuePlanes Current(shape, PLANES, halo);
+  seed(Current, 4711 + shape.dimensionCount());
+
+  ValuePlanes Expected(shape, PLANES, halo);
+  ExplicitSweep Reference(shape.dimensionCount(), StencilKernel::Scalar, stencil, Diffusion, Degradation);
+  Reference.setTile(tileX, tileY);
+
+  for (size_t k = 0; k < PLANES; ++k)
+    {
+      Reference.sweep(Current, Expected, SinglePlanes[k], DeltaT, steps, Region);
+    }
+
+  for (int Type = StencilKernel::Scalar; Type <= StencilKernel::AVX512; ++Type)
+    {
+      if (!StencilKernel::isSupported((StencilKernel::Type) Type)) continue;
+
+      for (int Threads = 1; Threads <= 3; Threads += 2)
+        {
+          ExplicitSweep Sweep(shape.dimensionCount(), (StencilKernel::Type) Type, stencil, Diffusion, Degradation);
+          Sweep.setThreads(Threads);
+          Sweep.setTile(tileX, tileY);
+
+          std::ostringstream Name;
+          Name << shape.dimensionCount() << "D";
+
+          if (shape.dimensionCount() == 3)
+            {
+              Name << " " << StencilKernel::Stencil3DNames[stencil] << " point";
+            }
+
+          Name << ", " << StencilKernel::TypeNames[Type] << ", threads: " << Threads
+               << ", tile: " << tileX << " x " << tileY << ", steps: " << steps;
+
+          ValuePlanes Next(shape, PLANES, halo);
+          Sweep.sweep(Current, Next, AllPlanes, DeltaT, steps, Region);
+          check(Name.str() + ", planes: " + "all", equal(Next, Expected));
+
+          ValuePlanes NextSingle(shape, PLANES, halo);
+
+          for (size_t k = 0; k < PLANES; ++k)
+            {
+              Sweep.sweep(Current, NextSingle, SinglePlanes[k], DeltaT, steps, Region);
+            }
+
+          check(Name.str() + ", planes: " + "single", equal(NextSingle, Expected));
+        }
+    }
+}
+
+/**
+ * Without degradation a uniform field is a steady state, i.e., the center weight must match the sum of
+ * the neighbor weights of the stencil.
+ */
+static void testConservation(const repast::Point< int > & shape, const StencilKernel::Stencil3D & stencil)
+{
+  const std::vector< double > Diffusion(DIFFUSION, DIFFUSION + PLANES);
+  const std::vector< double > Degradation(PLANES, 0.0);
+  std::vector< size_t > AllPlanes;
+
+  for (size_t k = 0; k < PLANES; ++k)
+    {
+      AllPlanes.push_back(k);
+    }
+
+  ValuePlanes Current(shape, PLANES, 1);
+  ValuePlanes Next(shape, PLANES, 1);
+  const ExplicitSweep::Region Extent = extent(shape, 1);
+  const ExplicitSweep::Region Region = extent(shape, 0);
+
+  for (size_t k = 0; k < PLANES; ++k)
+    for (int z = Extent.lower[2]; z < Extent.upper[2]; ++z)
+      for (int y = Extent.lower[1]; y < Extent.upper[1]; ++y)
+        for (int x = Extent.lower[0]; x < Extent.upper[0]; ++x)
+          {
+            Current(k, x, y, z) = 1.0;
+          }
+
+  ExplicitSweep Sweep(shape.dimensionCount(), StencilKernel::Scalar, stencil, Diffusion, Degradation);
+  Sweep.sweep(Current, Next, AllPlanes, 0.5, 1, Region);
+
+  bool Conserved = true;
+
+  for (size_t k = 0; k < PLANES; ++k)
+    for (int z = Region.lower[2]; z < Region.upper[2]; ++z)
+      for (int y = Region.lower[1]; y < Region.upper[1]; ++y)
+        for (int x = Region.lower[0]; x < Region.upper[0]; ++x)
+          {
+            Conserved &= fabs(Next(k, x, y, z) - 1.0) < 1e-12;
+          }
+
+  std::ostringstream Name;
+  Name << shape.dimensionCount() << "D";
+
+  if (shape.dimensionCount() == 3)
+    {
+      Name << " " << StencilKernel::Stencil3DNames[stencil] << " point";
+    }
+
+  check(Name.str() + ", uniform field is conserved", Conserved);
+}
+
+int main()
+{
+  // Odd extents leave remainders for all vector widths.
+  testSweep(repast::Point< int >(61), 1, StencilKernel::Point27, 0, 0, 1);
+
+  testSweep(repast::Point< int >(45, 29), 2, StencilKernel::Point27, 0, 0, 1);
+  testSweep(repast::Point< int >(45, 29), 2, StencilKernel::Point27, 8, 5, 1);
+  testSweep(repast::Point< int >(45, 29), 2, StencilKernel::Point27, 0, 0, 2);
+  testSweep(repast::Point< int >(45, 29), 2, StencilKernel::Point27, 8, 5, 2);
+
+  testSweep(repast::Point< int >(23, 11, 7), 1, StencilKernel::Point7, 0, 0, 1);
+  testSweep(repast::Point< int >(23, 11, 7), 1, StencilKernel::Point27, 0, 0, 1);
+
+  testConservation(repast::Point< int >(13), StencilKernel::Point27);
+  testConservation(repast::Point< int >(13, 9), StencilKernel::Point27);
+  testConservation(repast::Point< int >(13, 9, 5), StencilKernel::Point7);
+  testConservation(repast::Point< int >(13, 9, 5), StencilKernel::Point27);
+
+  std::cout << Failures << " failures" << std::endl;
+
+  return Failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}